@@ -4,22 +4,74 @@ property surface of a system.
 """
 
 import itertools
-from collections import OrderedDict
+import math
+from collections import OrderedDict, namedtuple
 import numpy as np
 from numpy import broadcast_to
 import pycalphad.variables as v
 from pycalphad import ConditionError
 from pycalphad.codegen.callables import build_phase_records
 from pycalphad.core.cache import cacheit
+from pycalphad.core.constants import FAKE_PHASE_NAME, FAKE_PHASE_ID
 from pycalphad.core.light_dataset import LightDataset
 from pycalphad.core.phase_rec import PhaseRecord
 from pycalphad.core.utils import endmember_matrix, extract_parameters, \
     filter_phases, instantiate_models, point_sample, \
-    unpack_components, unpack_condition, unpack_kwarg
+    unpack_components, unpack_condition, unpack_kwarg, unpack_site_fractions
+
+
+def _equivalent_sublattices(model):
+    """
+    Find groups of permutation-equivalent sublattices of an ordered phase.
+
+    Sublattices are equivalent if they have the same site ratio and the same constituents.
+    Only phases which are the ordered part of an order-disorder model are considered, because
+    the partitioned model is invariant to permuting their ordered sublattices.
+
+    Parameters
+    ----------
+    model : Model
+        Instance of a pycalphad Model
+
+    Returns
+    -------
+    List of tuples of sublattice indices. Groups with a single sublattice are omitted.
+    """
+    dbe = getattr(model, '_dbe', None)
+    if dbe is None or model.phase_name not in dbe.phases:
+        return []
+    if dbe.phases[model.phase_name].model_hints.get('ordered_phase', None) != model.phase_name:
+        return []
+    groups = OrderedDict()
+    for subl_idx, (site_ratio, constituents) in enumerate(zip(model.site_ratios, model.constituents)):
+        groups.setdefault((site_ratio, frozenset(constituents)), []).append(subl_idx)
+    return [tuple(group) for group in groups.values() if len(group) > 1]
+
+
+def _canonicalize_sublattice_order(points, sublattice_dof, equivalent_sublattices):
+    """
+    Map each point to the representative of its symmetry orbit by sorting the site fractions
+    of equivalent sublattices in descending lexicographic order, then remove duplicate points.
+    The order of first occurrence is preserved.
+    """
+    points = np.array(points, dtype=np.float_)
+    subl_offsets = np.concatenate(([0], np.cumsum(sublattice_dof)))
+    for group in equivalent_sublattices:
+        width = sublattice_dof[group[0]]
+        # (points, sublattices in group, site fractions in sublattice)
+        blocks = np.stack([points[:, subl_offsets[idx]:subl_offsets[idx]+width] for idx in group], axis=1)
+        # np.lexsort sorts by the last key first, so reverse the site fraction axis
+        order = np.lexsort(-blocks[..., ::-1].transpose(2, 0, 1), axis=-1)
+        sorted_blocks = np.take_along_axis(blocks, order[..., np.newaxis], axis=1)
+        for position, idx in enumerate(group):
+            points[:, subl_offsets[idx]:subl_offsets[idx]+width] = sorted_blocks[:, position]
+    # Round before comparing so that copies differing only by floating point noise collapse
+    _, unique_indices = np.unique(np.round(points, 12), axis=0, return_index=True)
+    return points[np.sort(unique_indices)]
 
 
 @cacheit
-def _sample_phase_constitution(model, sampler, fixed_grid, pdens):
+def _sample_phase_constitution(model, sampler, fixed_grid, pdens, symmetry_reduction=False):
     """
     Sample the internal degrees of freedom of a phase.
 
@@ -33,6 +85,9 @@ def _sample_phase_constitution(model, sampler, fixed_grid, pdens):
         If True, sample pdens points between each pair of endmembers
     pdens : int
         Number of points to sample in each sampled dimension
+    symmetry_reduction : bool, optional
+        If True, only sample one representative of each set of configurations related by
+        permuting equivalent sublattices of an ordered phase. See _equivalent_sublattices.
 
     Returns
     -------
@@ -58,22 +113,35 @@ def _sample_phase_constitution(model, sampler, fixed_grid, pdens):
                         for first_em, second_em in em_pairs]
         points = np.concatenate(list(itertools.chain([points], extra_points)))
 
+    equivalent_sublattices = _equivalent_sublattices(model) if symmetry_reduction else []
+    # Each representative stands in for this many symmetric copies of a generic configuration
+    orbit_size = int(np.prod([math.factorial(len(group)) for group in equivalent_sublattices]))
+
     # Sample composition space for more points
     if sum(sublattice_dof) > len(sublattice_dof):
-        points = np.concatenate((points, sampler(sublattice_dof, pdof=pdens)))
+        points = np.concatenate((points, sampler(sublattice_dof, pdof=max(1, int(np.ceil(pdens / orbit_size))))))
 
     # Filter out nan's that may have slipped in if we sampled too high a vacancy concentration
     # Issues with this appear to be platform-dependent
     points = points[~np.isnan(points).any(axis=-1)]
+    if len(equivalent_sublattices) > 0:
+        points = _canonicalize_sublattice_order(points, sublattice_dof, equivalent_sublattices)
     # Ensure that points has the correct dimensions and dtype
     points = np.atleast_2d(np.asarray(points, dtype=np.float_))
     return points
 
 
+def _evaluate_rows(phase_record, phase_output, dof, parameters, num_components):
+    "Evaluate a block of grid points without holding the GIL. Returns the masses of the components."
+    phase_compositions = np.zeros((dof.shape[0], num_components), order='F')
+    phase_record.obj_mass_2d_nogil(phase_output, phase_compositions, dof, parameters)
+    return phase_compositions
+
+
 def _compute_phase_values(components, statevar_dict,
-                          points, phase_record, output, maximum_internal_dof, broadcast=True,
+                          points, phase_record, output, broadcast=True,
                           parameters=None, fake_points=False,
-                          largest_energy=None):
+                          largest_energy=None, executor=None, rows_per_task=8192, phase_names=None):
     """
     Calculate output values for a particular phase.
 
@@ -89,9 +157,6 @@ def _compute_phase_values(components, statevar_dict,
         Contains callable for energy and phase metadata.
     output : string
         Desired name of the output result in the Dataset.
-    maximum_internal_dof : int
-        Largest number of internal degrees of freedom of any phase. This is used
-        to guarantee different phase's Datasets can be concatenated.
     broadcast : bool
         If True, broadcast state variables against each other to create a grid.
         If False, assume state variables are given as equal-length lists (or single-valued).
@@ -102,21 +167,41 @@ def _compute_phase_values(components, statevar_dict,
         If True, the first few points of the output surface will be fictitious
         points used to define an equilibrium hyperplane guaranteed to be above
         all the other points. This is used for convex hull computations.
+    executor : concurrent.futures.Executor, optional
+        Thread-based executor used to evaluate blocks of 'rows_per_task' grid points concurrently.
+    rows_per_task : int, optional
+        Number of grid points evaluated by each task submitted to 'executor'.
+    phase_names : list of str, optional
+        Lookup table of the integer phase codes in 'Phase_id'. The first entry must be
+        '_FAKE_'. Defaults to ['_FAKE_', phase_record.phase_name].
 
     Returns
     -------
     Dataset of the output attribute as a function of state variables
 
+    Notes
+    -----
+    Phases are identified by integer codes in 'Phase_id', which index the 'phase_names'
+    coordinate. Fictitious points have code FAKE_PHASE_ID.
+
+    Site fractions are not padded to a common number of internal degrees of freedom.
+    They are stored once in the 1-D 'Y_packed' buffer; 'Y_offsets' and 'Y_dof' give the
+    location and length of each point's site fractions in that buffer. Fictitious points
+    have no site fractions (Y_dof of zero).
+
     Examples
     --------
     None yet.
     """
+    phase_names = phase_names if phase_names is not None else [FAKE_PHASE_NAME, phase_record.phase_name]
+    phase_id = phase_names.index(phase_record.phase_name)
     if broadcast:
         # Broadcast compositions and state variables along orthogonal axes
         # This lets us eliminate an expensive Python loop
         statevars = np.meshgrid(*itertools.chain(statevar_dict.values(),
                                                      [np.empty(points.shape[-2])]),
                                     sparse=True, indexing='ij')[:-1]
+        packed_points = np.ascontiguousarray(points, dtype=np.float_).reshape(-1)
         points = broadcast_to(points, tuple(len(np.atleast_1d(x)) for x in statevar_dict.values()) + points.shape[-2:])
     else:
         statevars = list(np.atleast_1d(x) for x in statevar_dict.values())
@@ -129,6 +214,7 @@ def _compute_phase_values(components, statevar_dict,
                                  'broadcast=False.')
             statevars_.append(statevar)
         statevars = statevars_
+        packed_points = np.ascontiguousarray(points, dtype=np.float_).reshape(-1)
     pure_elements = [list(x.constituents.keys()) for x in components]
     pure_elements = sorted(set([el.upper() for constituents in pure_elements for el in constituents]))
     pure_elements = [x for x in pure_elements if x != 'VA']
@@ -141,17 +227,32 @@ def _compute_phase_values(components, statevar_dict,
 
     param_symbols, parameter_array = extract_parameters(parameters)
     parameter_array_length = parameter_array.shape[0]
-    if parameter_array_length == 0:
-        # No parameters specified
-        phase_output = np.zeros(dof.shape[0], order='C')
-        phase_record.obj_2d(phase_output, dof)
-    else:
-        # Vectorized parameter arrays
-        phase_output = np.zeros((dof.shape[0], parameter_array_length), order='C')
-        phase_record.obj_parameters_2d(phase_output, dof, parameter_array)
+    if executor is None:
+        if parameter_array_length == 0:
+            # No parameters specified
+            phase_output = np.zeros(dof.shape[0], order='C')
+            phase_record.obj_2d(phase_output, dof)
+        else:
+            # Vectorized parameter arrays
+            phase_output = np.zeros((dof.shape[0], parameter_array_length), order='C')
+            phase_record.obj_parameters_2d(phase_output, dof, parameter_array)
 
-    for el_idx in range(len(pure_elements)):
-        phase_record.mass_obj_2d(phase_compositions[:, el_idx], dof, el_idx)
+        for el_idx in range(len(pure_elements)):
+            phase_record.mass_obj_2d(phase_compositions[:, el_idx], dof, el_idx)
+    else:
+        if parameter_array_length == 0:
+            phase_output = np.zeros(dof.shape[0], order='C')
+            task_parameters = np.empty((0, 0))
+        else:
+            phase_output = np.zeros((dof.shape[0], parameter_array_length), order='C')
+            task_parameters = parameter_array
+        # Each task fills a disjoint block of rows, so results do not depend on scheduling
+        row_starts = range(0, dof.shape[0], rows_per_task)
+        futures = [executor.submit(_evaluate_rows, phase_record, phase_output[start:start+rows_per_task],
+                                   dof[start:start+rows_per_task], task_parameters, len(pure_elements))
+                   for start in row_starts]
+        for start, future in zip(row_starts, futures):
+            phase_compositions[start:start+rows_per_task] = future.result()
 
     max_tieline_vertices = len(pure_elements)
     if isinstance(phase_output, (float, int)):
@@ -173,34 +274,23 @@ def _compute_phase_values(components, statevar_dict,
         else:
             concat_axis = -1
         phase_output = np.concatenate((broadcast_to(largest_energy, output_shape), phase_output), axis=concat_axis)
-        phase_names = np.concatenate((broadcast_to('_FAKE_', points.shape[:-2] + (max_tieline_vertices,)),
-                                      np.full(points.shape[:-1], phase_record.phase_name, dtype='U' + str(len(phase_record.phase_name)))), axis=-1)
+        phase_ids = np.concatenate((np.full(points.shape[:-2] + (max_tieline_vertices,), FAKE_PHASE_ID, dtype=np.int16),
+                                    np.full(points.shape[:-1], phase_id, dtype=np.int16)), axis=-1)
     else:
-        phase_names = np.full(points.shape[:-1], phase_record.phase_name, dtype='U'+str(len(phase_record.phase_name)))
+        phase_ids = np.full(points.shape[:-1], phase_id, dtype=np.int16)
     if fake_points:
         phase_compositions = np.concatenate((np.broadcast_to(np.eye(len(pure_elements)), points.shape[:-2] + (max_tieline_vertices, len(pure_elements))), phase_compositions), axis=-2)
 
-    coordinate_dict = {'component': pure_elements}
-    # Resize 'points' so it has the same number of columns as the maximum
-    # number of internal degrees of freedom of any phase in the calculation.
-    # We do this so that everything is aligned for concat.
-    # Waste of memory? Yes, but the alternatives are unclear.
-    # In each case, first check if we need to do this...
-    # It can be expensive for many points (~14s for 500M points)
+    coordinate_dict = {'component': pure_elements, 'phase_names': np.asarray(phase_names)}
+    # Each point's site fractions are a contiguous block of the packed buffer.
+    # For broadcast grids, all state variable slices share the same buffer.
+    phase_dof = points.shape[-1]
+    point_offsets = broadcast_to(np.arange(points.shape[-2], dtype=np.int64) * phase_dof, points.shape[:-1])
+    point_dofs = broadcast_to(np.array(phase_dof, dtype=np.int32), points.shape[:-1])
     if fake_points:
-        desired_shape = points.shape[:-2] + (max_tieline_vertices + points.shape[-2], maximum_internal_dof)
-        expanded_points = np.full(desired_shape, np.nan)
-        expanded_points[..., len(pure_elements):, :points.shape[-1]] = points
-    else:
-        desired_shape = points.shape[:-1] + (maximum_internal_dof,)
-        if points.shape == desired_shape:
-            expanded_points = points
-        else:
-            # TODO: most optimal solution would be to take pre-extended arrays as an argument and remove this
-            # This still copies the array, but is more efficient than filling
-            # an array with np.nan, then copying the existing points
-            append_nans = np.full(desired_shape[:-1] + (desired_shape[-1] - points.shape[-1],), np.nan)
-            expanded_points = np.append(points, append_nans, axis=-1)
+        fake_shape = points.shape[:-2] + (max_tieline_vertices,)
+        point_offsets = np.concatenate((np.zeros(fake_shape, dtype=np.int64), point_offsets), axis=-1)
+        point_dofs = np.concatenate((np.zeros(fake_shape, dtype=np.int32), point_dofs), axis=-1)
     if broadcast:
         coordinate_dict.update({key: np.atleast_1d(value) for key, value in statevar_dict.items()})
         output_columns = [str(x) for x in statevar_dict.keys()] + ['points']
@@ -212,8 +302,10 @@ def _compute_phase_values(components, statevar_dict,
     else:
         parameter_column = []
     data_arrays = {'X': (output_columns + ['component'], phase_compositions),
-                   'Phase': (output_columns, phase_names),
-                   'Y': (output_columns + ['internal_dof'], expanded_points),
+                   'Phase_id': (output_columns, phase_ids),
+                   'Y_packed': (['packed_dof'], packed_points),
+                   'Y_offsets': (output_columns, point_offsets),
+                   'Y_dof': (output_columns, point_dofs),
                    output: (['dim_'+str(i) for i in range(len(phase_output.shape) - (len(output_columns)+len(parameter_column)))] + output_columns + parameter_column, phase_output)
                    }
     if not broadcast:
@@ -225,55 +317,21 @@ def _compute_phase_values(components, statevar_dict,
     return LightDataset(data_arrays, coords=coordinate_dict)
 
 
-def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, broadcast=True, parameters=None, to_xarray=True, **kwargs):
-    """
-    Sample the property surface of 'output' containing the specified
-    components and phases. Model parameters are taken from 'dbf' and any
-    state variables (T, P, etc.) can be specified as keyword arguments.
+_CalculationSetup = namedtuple('_CalculationSetup', ['components', 'statevar_dict', 'parameters', 'output',
+                                                     'models', 'phase_records', 'phase_names',
+                                                     'maximum_internal_dof', 'points_dict', 'pdens_dict',
+                                                     'sampler_dict', 'fixedgrid_dict', 'symmetry_dict'])
 
-    Parameters
-    ----------
-    dbf : Database
-        Thermodynamic database containing the relevant parameters.
-    comps : str or sequence
-        Names of components to consider in the calculation.
-    phases : str or sequence
-        Names of phases to consider in the calculation.
-    mode : string, optional
-        See 'make_callable' docstring for details.
-    output : string, optional
-        Model attribute to sample.
-    fake_points : bool, optional (Default: False)
-        If True, the first few points of the output surface will be fictitious
-        points used to define an equilibrium hyperplane guaranteed to be above
-        all the other points. This is used for convex hull computations.
-    broadcast : bool, optional
-        If True, broadcast given state variable lists against each other to create a grid.
-        If False, assume state variables are given as equal-length lists.
-    points : ndarray or a dict of phase names to ndarray, optional
-        Columns of ndarrays must be internal degrees of freedom (site fractions), sorted.
-        If this is not specified, points will be generated automatically.
-    pdens : int, a dict of phase names to int, or a seq of both, optional
-        Number of points to sample per degree of freedom.
-        Default: 2000; Default when called from equilibrium(): 500
-    model : Model, a dict of phase names to Model, or a seq of both, optional
-        Model class to use for each phase.
-    sampler : callable, a dict of phase names to callable, or a seq of both, optional
-        Function to sample phase constitution space.
-        Must have same signature as 'pycalphad.core.utils.point_sample'
-    grid_points : bool, a dict of phase names to bool, or a seq of both, optional (Default: True)
-        Whether to add evenly spaced points between end-members.
-        The density of points is determined by 'pdens'
-    parameters : dict, optional
-        Maps SymPy Symbol to numbers, for overriding the values of parameters in the Database.
+
+def _setup_calculation(dbf, comps, phases, output, broadcast, parameters, kwargs):
+    """
+    Validate the arguments of calculate() and build the models and PhaseRecords
+    of the active phases. Special keyword arguments are popped from 'kwargs'; the
+    remaining ones are taken as state variables.
 
     Returns
     -------
-    Dataset of the sampled attribute as a function of state variables
-
-    Examples
-    --------
-    None yet.
+    _CalculationSetup
     """
     # Here we check for any keyword arguments that are special, i.e.,
     # there may be keyword arguments that aren't state variables
@@ -282,6 +340,7 @@ def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, bro
     callables = kwargs.pop('callables', {})
     sampler_dict = unpack_kwarg(kwargs.pop('sampler', None), default_arg=None)
     fixedgrid_dict = unpack_kwarg(kwargs.pop('grid_points', True), default_arg=True)
+    symmetry_dict = unpack_kwarg(kwargs.pop('symmetry_reduction', False), default_arg=False)
     parameters = parameters or dict()
     if isinstance(parameters, dict):
         parameters = OrderedDict(sorted(parameters.items(), key=str))
@@ -294,9 +353,6 @@ def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, bro
         raise ValueError('The \'points\' keyword argument must be specified if broadcast=False is also given.')
     nonvacant_components = [x for x in sorted(comps) if x.number_of_atoms > 0]
 
-    all_phase_data = []
-    largest_energy = 1e10
-
     # Consider only the active phases
     list_of_possible_phases = filter_phases(dbf, comps)
     if len(list_of_possible_phases) == 0:
@@ -329,20 +385,101 @@ def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, bro
                                    verbose=kwargs.pop('verbose', False))
     str_statevar_dict = OrderedDict((str(key), unpack_condition(value)) for (key, value) in statevar_dict.items())
     maximum_internal_dof = max(len(models[phase_name].site_fractions) for phase_name in active_phases)
-    for phase_name in sorted(active_phases):
-        mod = models[phase_name]
-        phase_record = phase_records[phase_name]
-        points = points_dict[phase_name]
-        if points is None:
-            points = _sample_phase_constitution(mod, sampler_dict[phase_name] or point_sample,
-                                                fixedgrid_dict[phase_name], pdens_dict[phase_name])
-        points = np.atleast_2d(points)
-
-        fp = fake_points and (phase_name == sorted(active_phases)[0])
-        phase_ds = _compute_phase_values(nonvacant_components, str_statevar_dict,
-                                         points, phase_record, output,
-                                         maximum_internal_dof, broadcast=broadcast, parameters=parameters,
-                                         largest_energy=float(largest_energy), fake_points=fp)
+    return _CalculationSetup(components=nonvacant_components, statevar_dict=str_statevar_dict,
+                             parameters=parameters, output=output, models=models, phase_records=phase_records,
+                             phase_names=sorted(active_phases), maximum_internal_dof=maximum_internal_dof,
+                             points_dict=points_dict, pdens_dict=pdens_dict, sampler_dict=sampler_dict,
+                             fixedgrid_dict=fixedgrid_dict, symmetry_dict=symmetry_dict)
+
+
+def _phase_points(setup, phase_name):
+    "Return the user-specified points of a phase, or sample them if none were given."
+    points = setup.points_dict[phase_name]
+    if points is None:
+        points = _sample_phase_constitution(setup.models[phase_name],
+                                            setup.sampler_dict[phase_name] or point_sample,
+                                            setup.fixedgrid_dict[phase_name], setup.pdens_dict[phase_name],
+                                            symmetry_reduction=setup.symmetry_dict[phase_name])
+    return np.atleast_2d(points)
+
+
+def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, broadcast=True, parameters=None, to_xarray=True,
+              executor=None, **kwargs):
+    """
+    Sample the property surface of 'output' containing the specified
+    components and phases. Model parameters are taken from 'dbf' and any
+    state variables (T, P, etc.) can be specified as keyword arguments.
+
+    Parameters
+    ----------
+    dbf : Database
+        Thermodynamic database containing the relevant parameters.
+    comps : str or sequence
+        Names of components to consider in the calculation.
+    phases : str or sequence
+        Names of phases to consider in the calculation.
+    mode : string, optional
+        See 'make_callable' docstring for details.
+    output : string, optional
+        Model attribute to sample.
+    fake_points : bool, optional (Default: False)
+        If True, the first few points of the output surface will be fictitious
+        points used to define an equilibrium hyperplane guaranteed to be above
+        all the other points. This is used for convex hull computations.
+    broadcast : bool, optional
+        If True, broadcast given state variable lists against each other to create a grid.
+        If False, assume state variables are given as equal-length lists.
+    points : ndarray or a dict of phase names to ndarray, optional
+        Columns of ndarrays must be internal degrees of freedom (site fractions), sorted.
+        If this is not specified, points will be generated automatically.
+    pdens : int, a dict of phase names to int, or a seq of both, optional
+        Number of points to sample per degree of freedom.
+        Default: 2000; Default when called from equilibrium(): 500
+    model : Model, a dict of phase names to Model, or a seq of both, optional
+        Model class to use for each phase.
+    sampler : callable, a dict of phase names to callable, or a seq of both, optional
+        Function to sample phase constitution space.
+        Must have same signature as 'pycalphad.core.utils.point_sample'
+    grid_points : bool, a dict of phase names to bool, or a seq of both, optional (Default: True)
+        Whether to add evenly spaced points between end-members.
+        The density of points is determined by 'pdens'
+    symmetry_reduction : bool, a dict of phase names to bool, or a seq of both, optional (Default: False)
+        Whether to sample only one representative of configurations of ordered phases which are
+        equivalent by permuting sublattices with the same site ratio and constituents (e.g., the
+        four substitutional sublattices of an L1_2 model). This assumes the ordered parameters
+        respect that symmetry, as required by the partitioned order-disorder model.
+    parameters : dict, optional
+        Maps SymPy Symbol to numbers, for overriding the values of parameters in the Database.
+    to_xarray : bool, optional (Default: True)
+        If True, return an xarray Dataset with site fractions in the NaN-padded 'Y' variable.
+        If False, return a LightDataset with site fractions stored without padding in
+        'Y_packed', indexed by 'Y_offsets' and 'Y_dof' (see `unpack_site_fractions`), and
+        with integer phase codes in 'Phase_id', indexing the 'phase_names' coordinate.
+    executor : concurrent.futures.Executor, optional
+        If specified, blocks of grid points of each phase are evaluated concurrently
+        by this executor. It must be thread-based, e.g., ThreadPoolExecutor, because
+        results are written in place. The result does not depend on the executor.
+
+    Returns
+    -------
+    Dataset of the sampled attribute as a function of state variables
+
+    Examples
+    --------
+    None yet.
+    """
+    setup = _setup_calculation(dbf, comps, phases, output, broadcast, parameters, kwargs)
+    all_phase_data = []
+    largest_energy = 1e10
+    phase_name_table = [FAKE_PHASE_NAME] + setup.phase_names
+    for phase_name in setup.phase_names:
+        points = _phase_points(setup, phase_name)
+        fp = fake_points and (phase_name == setup.phase_names[0])
+        phase_ds = _compute_phase_values(setup.components, setup.statevar_dict,
+                                         points, setup.phase_records[phase_name], setup.output,
+                                         broadcast=broadcast, parameters=setup.parameters,
+                                         largest_energy=float(largest_energy), fake_points=fp,
+                                         executor=executor, phase_names=phase_name_table)
         all_phase_data.append(phase_ds)
 
     # speedup for single-phase case (found by profiling)
@@ -351,18 +488,154 @@ def calculate(dbf, comps, phases, mode=None, output='GM', fake_points=False, bro
 
         data_vars = all_phase_data[0].data_vars
         concatenated_data_vars = {}
+        # Shift each phase's offsets so they index into the concatenated packed buffer
+        packed_sizes = [phase_data.Y_packed.shape[0] for phase_data in all_phase_data]
+        packed_bases = np.concatenate(([0], np.cumsum(packed_sizes)[:-1]))
         for var in data_vars.keys():
             data_coords = data_vars[var][0]
+            if var == 'Y_packed':
+                concatenated_data_vars[var] = (data_coords, np.concatenate([phase_data.Y_packed for phase_data in all_phase_data]))
+                continue
             points_idx = data_coords.index('points')  # concatenation axis
             arrs = []
-            for phase_data in all_phase_data:
-                arrs.append(getattr(phase_data, var))
+            for phase_data, packed_base in zip(all_phase_data, packed_bases):
+                if var == 'Y_offsets':
+                    arrs.append(phase_data.Y_offsets + packed_base)
+                else:
+                    arrs.append(getattr(phase_data, var))
             concat_data = np.concatenate(arrs, axis=points_idx)
             concatenated_data_vars[var] = (data_coords, concat_data)
         final_ds = LightDataset(data_vars=concatenated_data_vars, coords=concatenated_coords)
     else:
         final_ds = all_phase_data[0]
     if to_xarray:
+        # Materialize the padded site fraction array expected by Dataset users
+        y_dims = final_ds.data_vars['Y_offsets'][0] + ['internal_dof']
+        final_ds.add_variable('Y', y_dims, unpack_site_fractions(final_ds.Y_packed, final_ds.Y_offsets,
+                                                                 final_ds.Y_dof, setup.maximum_internal_dof))
+        final_ds.add_variable('Phase', final_ds.data_vars['Phase_id'][0], final_ds.phase_names[final_ds.Phase_id])
+        for var in ('Y_packed', 'Y_offsets', 'Y_dof', 'Phase_id'):
+            final_ds.remove(var)
+        del final_ds.coords['phase_names']
         return final_ds.get_dataset()
     else:
         return final_ds
+
+
+def _grid_point_nbytes(setup, phase_name):
+    "Approximate peak memory needed by _compute_phase_values per (state variable, point) pair."
+    num_statevars = len(setup.statevar_dict)
+    phase_dof = len(setup.models[phase_name].site_fractions)
+    num_components = len(setup.components)
+    num_samples = max(1, extract_parameters(setup.parameters)[1].shape[0])
+    # Input dof array, GM and the X array (built once, then copied into the output)
+    float_count = num_statevars + phase_dof + num_samples + 2 * num_components
+    # Y_offsets, Y_dof and Phase_id
+    return 8 * float_count + 8 + 4 + 2
+
+
+def _chunk_slices(shape, max_cells):
+    """
+    Split an array shape into hyperslabs of at most 'max_cells' elements (at least one element each).
+    Leading axes are iterated one index at a time, one axis is split into blocks and trailing axes
+    are taken whole, so every hyperslab remains a regular grid.
+    """
+    max_cells = max(1, int(max_cells))
+    split_axis = len(shape) - 1
+    trailing_cells = 1
+    while split_axis >= 0 and trailing_cells * shape[split_axis] <= max_cells:
+        trailing_cells *= shape[split_axis]
+        split_axis -= 1
+    if split_axis < 0:
+        yield tuple(slice(0, size) for size in shape)
+        return
+    block = max(1, max_cells // trailing_cells)
+    for leading_idx in itertools.product(*[range(size) for size in shape[:split_axis]]):
+        for start in range(0, shape[split_axis], block):
+            yield tuple(slice(i, i+1) for i in leading_idx) + \
+                (slice(start, min(start + block, shape[split_axis])),) + \
+                tuple(slice(0, size) for size in shape[split_axis+1:])
+
+
+def calculate_chunked(dbf, comps, phases, mode=None, output='GM', fake_points=False, broadcast=True,
+                      parameters=None, memory_budget=2**28, executor=None, **kwargs):
+    """
+    Sample the property surface of 'output' like calculate(), but yield the result
+    in pieces whose size is bounded by 'memory_budget', one phase at a time.
+
+    Parameters
+    ----------
+    dbf : Database
+        Thermodynamic database containing the relevant parameters.
+    comps : str or sequence
+        Names of components to consider in the calculation.
+    phases : str or sequence
+        Names of phases to consider in the calculation.
+    mode : string, optional
+        See 'make_callable' docstring for details.
+    output : string, optional
+        Model attribute to sample.
+    fake_points : bool, optional (Default: False)
+        If True, the chunks of the first phase which start at its first point are
+        prefixed with the fictitious points used for convex hull computations.
+    broadcast : bool, optional
+        If True, broadcast given state variable lists against each other to create a grid.
+        If False, assume state variables are given as equal-length lists.
+    parameters : dict, optional
+        Maps SymPy Symbol to numbers, for overriding the values of parameters in the Database.
+    memory_budget : int, optional
+        Approximate number of bytes which may be used to compute a single chunk.
+        A chunk always contains at least one point at one set of state variables.
+    executor : concurrent.futures.Executor, optional
+        Thread-based executor used to evaluate each chunk. See calculate().
+    kwargs :
+        State variables and the 'points', 'pdens', 'model', 'sampler', 'grid_points',
+        'symmetry_reduction' and 'callables' options accepted by calculate().
+
+    Yields
+    ------
+    phase_name : str
+        Name of the phase sampled in this chunk.
+    index : tuple of slice
+        Position of this chunk in the grid of the phase. If broadcast=True, there is one slice
+        per state variable (sorted by name, as in the result of calculate()) followed by a slice
+        over the points of the phase. If broadcast=False, there is a single slice over the points.
+        Fictitious points are not counted.
+    chunk : LightDataset
+        Result of the chunk, with the same variables as calculate(..., to_xarray=False).
+
+    Examples
+    --------
+    >>> for phase_name, index, chunk in calculate_chunked(dbf, comps, phases, T=temps, memory_budget=2**30):  # doctest: +SKIP
+    ...     store[phase_name][index] = chunk.GM
+    """
+    setup = _setup_calculation(dbf, comps, phases, output, broadcast, parameters, kwargs)
+    largest_energy = 1e10
+    phase_name_table = [FAKE_PHASE_NAME] + setup.phase_names
+    for phase_name in setup.phase_names:
+        points = _phase_points(setup, phase_name)
+        fp = fake_points and (phase_name == setup.phase_names[0])
+        max_cells = memory_budget // _grid_point_nbytes(setup, phase_name)
+        if broadcast:
+            statevar_values = [np.atleast_1d(value) for value in setup.statevar_dict.values()]
+            grid_shape = tuple(len(value) for value in statevar_values) + (points.shape[0],)
+        else:
+            statevar_values = None
+            grid_shape = (points.shape[0],)
+        for index in _chunk_slices(grid_shape, max_cells):
+            point_slice = index[-1]
+            if broadcast:
+                chunk_statevars = OrderedDict((key, value[sv_slice]) for key, value, sv_slice
+                                              in zip(setup.statevar_dict.keys(), statevar_values, index[:-1]))
+            else:
+                # Single-valued state variables apply to every point
+                chunk_statevars = OrderedDict((key, value if len(np.atleast_1d(value)) == 1
+                                               else np.atleast_1d(value)[point_slice])
+                                              for key, value in setup.statevar_dict.items())
+            chunk = _compute_phase_values(setup.components, chunk_statevars,
+                                          points[point_slice], setup.phase_records[phase_name], setup.output,
+                                          broadcast=broadcast, parameters=setup.parameters,
+                                          largest_energy=float(largest_energy),
+                                          fake_points=fp and point_slice.start == 0, executor=executor,
+                                          phase_names=phase_name_table)
+            yield phase_name, index, chunk
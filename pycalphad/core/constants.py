@@ -10,5 +10,15 @@ MIN_PHASE_FRACTION = 1e-6
 # the purposes of CompositionSet addition and removal during energy minimization.
 COMP_DIFFERENCE_TOL = 1e-4
 
+# Fictitious points of sampled grids belong to this pseudo-phase. Grids identify phases by integer codes which
+# index a table of phase names; the fictitious phase is always the first entry.
+FAKE_PHASE_NAME = '_FAKE_'
+FAKE_PHASE_ID = 0
+
+# Grid points whose energy is more than GRID_PRUNING_MARGIN (J/mol-atom) above the hyperplane through the lowest
+# energy pure-component points can never be on the lower convex hull, and are dropped before the starting point
+# calculation. The margin keeps some metastable points available to the solver when it adds new phases.
+GRID_PRUNING_MARGIN = 1e4
+
 # Constraint scaling factors, for numerical stability
 INTERNAL_CONSTRAINT_SCALING = 1.0
@@ -27,9 +27,12 @@ cdef bint add_new_phases(object composition_sets, object removed_compsets, objec
     cdef int df_idx = 0
     cdef double largest_df = -np.inf
     cdef double[:] df_comp
-    cdef double[:,::1] current_grid_Y = grid.Y[*current_idx, ...]
+    cdef double[::1] grid_Y_packed = grid.Y_packed
+    cdef np.int64_t[::1] current_grid_Y_offsets = np.ascontiguousarray(grid.Y_offsets[*current_idx, ...], dtype=np.int64)
+    cdef np.int64_t df_offset
     cdef double[:,::1] current_grid_X = grid.X[*current_idx, ...]
-    cdef np.ndarray current_grid_Phase = grid.Phase[*current_idx, ...]
+    cdef np.int16_t[:] current_grid_Phase_id = grid.Phase_id[*current_idx, ...]
+    cdef list grid_phase_names = list(grid.phase_names)
     cdef unicode df_phase_name
     cdef CompositionSet compset = composition_sets[0]
     cdef int num_statevars = len(compset.phase_record.state_variables)
@@ -37,15 +40,15 @@ cdef bint add_new_phases(object composition_sets, object removed_compsets, objec
     driving_forces = (chemical_potentials * current_grid_X).sum(axis=-1) - grid.GM[*current_idx, ...]
     for i in range(driving_forces.shape[0]):
         if driving_forces[i] > largest_df:
-            df_comp = current_grid_Y[i]
-            df_phase_name = <unicode>current_grid_Phase[i]
+            df_offset = current_grid_Y_offsets[i]
+            df_phase_name = <unicode>grid_phase_names[current_grid_Phase_id[i]]
             distinct = True
             for compset in removed_compsets:
                 if df_phase_name != compset.phase_record.phase_name:
                     continue
                 distinct = False
                 for comp_idx in range(compset.phase_record.phase_dof):
-                    if abs(df_comp[comp_idx] - compset.dof[num_statevars+comp_idx]) > 10*COMP_DIFFERENCE_TOL:
+                    if abs(grid_Y_packed[df_offset+comp_idx] - compset.dof[num_statevars+comp_idx]) > 10*COMP_DIFFERENCE_TOL:
                         distinct = True
                         break
                 if not distinct:
@@ -59,11 +62,11 @@ cdef bint add_new_phases(object composition_sets, object removed_compsets, objec
     if largest_df > minimum_df:
         # To add a phase, must not be within COMP_DIFFERENCE_TOL of composition of the same phase of its type
         df_comp = current_grid_X[df_idx]
-        df_phase_name = <unicode>current_grid_Phase[df_idx]
-        if df_phase_name == '_FAKE_':
+        if current_grid_Phase_id[df_idx] == FAKE_PHASE_ID:
             if verbose:
                 print('Chemical potentials are poorly conditioned')
             return False
+        df_phase_name = <unicode>grid_phase_names[current_grid_Phase_id[df_idx]]
         for compset in composition_sets:
             if compset.phase_record.phase_name != df_phase_name:
                 continue
@@ -76,7 +79,8 @@ cdef bint add_new_phases(object composition_sets, object removed_compsets, objec
                     print('Candidate composition set ' + df_phase_name + ' at ' + str(np.array(df_comp)) + ' is not distinct')
                 return False
         compset = CompositionSet(phase_records[df_phase_name])
-        compset.update(current_grid_Y[df_idx, :compset.phase_record.phase_dof], 1e-6,
+        df_offset = current_grid_Y_offsets[df_idx]
+        compset.update(grid_Y_packed[df_offset:df_offset+compset.phase_record.phase_dof], 1e-6,
                        state_variables)
         composition_sets.append(compset)
         if verbose:
@@ -118,7 +122,7 @@ cdef _solve_and_update_if_converged(composition_sets, comps, cur_conds, problem,
     return result
 
 def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys, state_variables, verbose,
-                            problem=Problem, solver=None):
+                            problem=Problem, solver=None, diagnostics=False):
     """
     Compute equilibrium for the given conditions.
     This private function is meant to be called from a worker subprocess.
@@ -144,6 +148,9 @@ def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys,
     solver : pycalphad.core.solver.SolverBase
         Instance of a SolverBase subclass. If None is supplied, defaults to a
         pycalphad.core.solver.InteriorPointSolver
+    diagnostics : bool, optional
+        If True, add the total number of solver iterations at each condition to properties,
+        as the integer variable 'solver_iterations'. It is zero where the solver does not report iterations.
 
     Returns
     -------
@@ -179,6 +186,7 @@ def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys,
     prop_Y_values = properties.Y
     prop_GM_values = properties.GM
     str_state_variables = [str(k) for k in state_variables if str(k) in grid.coords.keys()]
+    solver_iterations = np.zeros(prop_GM_values.shape, dtype=np.int32) if diagnostics else None
     it = np.nditer(prop_GM_values, flags=['multi_index'])
 
     while not it.finished:
@@ -234,6 +242,8 @@ def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys,
                 changed_phases = False
                 break
             result = _solve_and_update_if_converged(composition_sets, comps, cur_conds, problem, iter_solver)
+            if diagnostics and result.iterations is not None:
+                solver_iterations[it.multi_index] += result.iterations
 
             chemical_potentials[:] = result.chemical_potentials
             changed_phases |= add_new_phases(composition_sets, removed_compsets, phase_records,
@@ -244,6 +254,8 @@ def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys,
                 break
         if changed_phases:
             result = _solve_and_update_if_converged(composition_sets, comps, cur_conds, problem, iter_solver)
+            if diagnostics and result.iterations is not None:
+                solver_iterations[it.multi_index] += result.iterations
             chemical_potentials[:] = result.chemical_potentials
         if not iter_solver.ignore_convergence:
             converged = result.converged
@@ -288,4 +300,6 @@ def _solve_eq_at_conditions(comps, properties, phase_records, grid, conds_keys,
             prop_GM_values[it.multi_index] = np.nan
             prop_Phase_values[it.multi_index] = ''
         it.iternext()
+    if diagnostics:
+        properties.add_variable('solver_iterations', list(conds_keys), solver_iterations)
     return properties
@@ -8,6 +8,7 @@ from pycalphad.core.utils import unpack_components, unpack_condition, unpack_pha
 from pycalphad import calculate
 from pycalphad.core.errors import EquilibriumError, ConditionError
 from pycalphad.core.starting_point import starting_point
+from pycalphad.core.lower_convex_hull import prune_grid
 from pycalphad.codegen.callables import build_phase_records
 from pycalphad.core.eqsolver import _solve_eq_at_conditions
 from pycalphad.core.solver import SundmanSolver
@@ -139,7 +140,7 @@ def _eqcalculate(dbf, comps, phases, conditions, output, data=None, per_phase=Fa
 def equilibrium(dbf, comps, phases, conditions, output=None, model=None,
                 verbose=False, broadcast=True, calc_opts=None, to_xarray=True,
                 scheduler='sync', parameters=None, solver=None, callables=None,
-                **kwargs):
+                out_dir=None, executor=None, diagnostics=False, **kwargs):
     """
     Calculate the equilibrium state of a system containing the specified
     components and phases, under the specified conditions.
@@ -180,6 +181,21 @@ def equilibrium(dbf, comps, phases, conditions, output=None, model=None,
         Defaults to a pycalphad.core.solver.InteriorPointSolver.
     callables : dict, optional
         Pre-computed callable functions for equilibrium calculation.
+    out_dir : str, optional
+        Existing directory in which the result arrays are stored as memory-mapped .npy files,
+        so that the result is not limited by available memory. Each condition is written in
+        place as it is solved. Results can be reopened with
+        pycalphad.core.light_dataset.open_memmap_dataset. Properties requested through
+        'output' (other than GM and MU) are computed in memory and are not stored.
+    executor : concurrent.futures.Executor, optional
+        Thread-based executor (e.g., ThreadPoolExecutor) used to sample the energy surface
+        and to find starting points at blocks of conditions concurrently. An executor
+        given in calc_opts takes precedence for sampling. The result does not depend
+        on the executor.
+    diagnostics : bool, optional
+        If True, add per-condition solver statistics to the result: the hyperplane() statistics
+        of the starting point as 'hull_' variables (see `lower_convex_hull`), and the total
+        number of solver iterations as 'solver_iterations'. They are not memory-mapped.
 
     Returns
     -------
@@ -250,16 +266,24 @@ def equilibrium(dbf, comps, phases, conditions, output=None, model=None,
 
     if 'pdens' not in grid_opts:
         grid_opts['pdens'] = 50
+    if executor is not None and 'executor' not in grid_opts:
+        grid_opts['executor'] = executor
     grid = calculate(dbf, comps, active_phases, model=models, fake_points=True,
                      callables=callables, output='GM', parameters=parameters,
                      to_xarray=False, **grid_opts)
+    grid = prune_grid(grid)
     coord_dict = str_conds.copy()
     coord_dict['vertex'] = np.arange(len(pure_elements) + 1)  # +1 is to accommodate the degenerate degree of freedom at the invariant reactions
     coord_dict['component'] = pure_elements
-    properties = starting_point(conds, state_variables, phase_records, grid)
+    properties = starting_point(conds, state_variables, phase_records, grid, out_dir=out_dir,
+                                executor=executor, diagnostics=diagnostics)
     properties = _solve_eq_at_conditions(comps, properties, phase_records, grid,
                                          list(str_conds.keys()), state_variables,
-                                         verbose, solver=solver)
+                                         verbose, solver=solver, diagnostics=diagnostics)
+    if out_dir is not None:
+        for _, values in properties.data_vars.values():
+            if isinstance(values, np.memmap):
+                values.flush()
 
     # Compute equilibrium values of any additional user-specified properties
     # We already computed these properties so don't recompute them
@@ -1,10 +1,41 @@
 # distutils: language = c++
-cpdef double hyperplane(double[:,::1] compositions,
-                        double[::1] energies,
-                        double[::1] composition,
+cdef struct HyperplaneBuffers:
+    int point_capacity
+    int simplex_capacity
+    int component_capacity
+    # 1-D
+    int* remaining_point_indices
+    int* included_composition_indices
+    int* best_guess_simplex
+    int* free_chempot_indices
+    int* candidate_simplex
+    int* int_tmp
+    double* candidate_potentials
+    double* smallest_fractions
+    double* driving_forces
+    double* compact_energies
+    double* all_potentials
+    # 2-D
+    int* trial_simplices
+    double* fractions
+    double* f_contig_trial
+    double* f_candidate_tieline
+    double* compact_compositions
+    # 3-D
+    double* f_trial_matrix
+
+cdef class HyperplaneWorkspace:
+    cdef HyperplaneBuffers buffers
+
+cpdef double hyperplane(const double[:,::1] compositions,
+                        const double[::1] energies,
+                        const double[::1] composition,
                         double[::1] chemical_potentials,
                         double total_moles,
-                        size_t[::1] fixed_chempot_indices,
-                        size_t[::1] fixed_comp_indices,
+                        const size_t[::1] fixed_chempot_indices,
+                        const size_t[::1] fixed_comp_indices,
                         double[::1] result_fractions,
-                        int[::1] result_simplex) nogil except *
+                        int[::1] result_simplex,
+                        HyperplaneWorkspace workspace=*,
+                        const int[::1] initial_simplex=*,
+                        int[::1] statistics=*) except * nogil
@@ -2,12 +2,22 @@
 cimport numpy as np
 import numpy as np
 cimport cython
-from libc.stdlib cimport malloc, free
+from libc.stdlib cimport malloc, realloc, free
+from libc.string cimport memset
+from libc.math cimport NAN
 cimport scipy.linalg.cython_lapack as cython_lapack
+cimport scipy.linalg.cython_blas as cython_blas
+from pycalphad.core.constants import FAKE_PHASE_ID
+
+cdef np.int16_t _FAKE_PHASE_ID = FAKE_PHASE_ID
+
+# Entries of the statistics array filled by hyperplane()
+HYPERPLANE_STATISTICS = ('iterations', 'singular_solves', 'points_after_first_pass', 'points_remaining')
 
 
 @cython.boundscheck(False)
-cdef void solve(double* A, int N, double* x, int* ipiv) nogil:
+cdef bint solve(double* A, int N, double* x, int* ipiv) noexcept nogil:
+    "Solve A x = b in place. Returns True if A is singular."
     cdef int i
     cdef int info = 0
     cdef int NRHS = 1
@@ -16,17 +26,18 @@ cdef void solve(double* A, int N, double* x, int* ipiv) nogil:
     if info != 0:
         for i in range(N):
             x[i] = -1e19
+    return info != 0
 
 
 @cython.boundscheck(False)
-cdef void prodsum(double[::1] chempots, double[:,::1] points, double[::1] result) nogil:
+cdef void prodsum(double[::1] chempots, double[:,::1] points, double[::1] result) noexcept nogil:
     for i in range(chempots.shape[0]):
         for j in range(result.shape[0]):
             result[j] -= chempots[i]*points[j,i]
 
 
 @cython.boundscheck(False)
-cdef double _min(double* a, int a_shape) nogil:
+cdef double _min(double* a, int a_shape) noexcept nogil:
     cdef int i
     cdef double result = 1e300
     for i in range(a_shape):
@@ -35,7 +46,7 @@ cdef double _min(double* a, int a_shape) nogil:
     return result
 
 @cython.boundscheck(False)
-cdef int argmin(double* a, int a_shape, double* lowest) nogil:
+cdef int argmin(double* a, int a_shape, double* lowest) noexcept nogil:
     cdef int i
     cdef int result = 0
     for i in range(a_shape):
@@ -46,7 +57,7 @@ cdef int argmin(double* a, int a_shape, double* lowest) nogil:
 
 
 @cython.boundscheck(False)
-cdef int argmax(double* a, int a_shape) nogil:
+cdef int argmax(double* a, int a_shape) noexcept nogil:
     cdef int i
     cdef int result = 0
     cdef double highest = -1e30
@@ -56,16 +67,117 @@ cdef int argmax(double* a, int a_shape) nogil:
             result = i
     return result
 
+cdef void _reserve_buffers(HyperplaneBuffers* buf, int num_points, int num_components, int simplex_size) noexcept nogil:
+    "Grow the buffers to fit num_points points of num_components components and a simplex of simplex_size vertices."
+    if num_points > buf.point_capacity or num_components > buf.component_capacity:
+        num_points = max(num_points, buf.point_capacity)
+        num_components = max(num_components, buf.component_capacity)
+        buf.compact_compositions = <double*>realloc(buf.compact_compositions, num_points * num_components * sizeof(double))
+        buf.all_potentials = <double*>realloc(buf.all_potentials, num_components * sizeof(double))
+        buf.component_capacity = num_components
+    if num_points > buf.point_capacity:
+        buf.remaining_point_indices = <int*>realloc(buf.remaining_point_indices, num_points * sizeof(int))
+        buf.driving_forces = <double*>realloc(buf.driving_forces, num_points * sizeof(double))
+        buf.compact_energies = <double*>realloc(buf.compact_energies, num_points * sizeof(double))
+        buf.point_capacity = num_points
+    if simplex_size > buf.simplex_capacity:
+        # +1 for the N=1 condition
+        buf.included_composition_indices = <int*>realloc(buf.included_composition_indices, (simplex_size + 1) * sizeof(int))
+        buf.best_guess_simplex = <int*>realloc(buf.best_guess_simplex, simplex_size * sizeof(int))
+        buf.free_chempot_indices = <int*>realloc(buf.free_chempot_indices, simplex_size * sizeof(int))
+        buf.candidate_simplex = <int*>realloc(buf.candidate_simplex, simplex_size * sizeof(int))
+        buf.int_tmp = <int*>realloc(buf.int_tmp, simplex_size * sizeof(int))
+        buf.candidate_potentials = <double*>realloc(buf.candidate_potentials, simplex_size * sizeof(double))
+        buf.smallest_fractions = <double*>realloc(buf.smallest_fractions, simplex_size * sizeof(double))
+        buf.trial_simplices = <int*>realloc(buf.trial_simplices, simplex_size * simplex_size * sizeof(int))
+        buf.fractions = <double*>realloc(buf.fractions, simplex_size * simplex_size * sizeof(double))
+        buf.f_contig_trial = <double*>realloc(buf.f_contig_trial, simplex_size * simplex_size * sizeof(double))
+        buf.f_candidate_tieline = <double*>realloc(buf.f_candidate_tieline, simplex_size * simplex_size * sizeof(double))
+        buf.f_trial_matrix = <double*>realloc(buf.f_trial_matrix, simplex_size * simplex_size * simplex_size * sizeof(double))
+        buf.simplex_capacity = simplex_size
+
+
+cdef void _free_buffers(HyperplaneBuffers* buf) noexcept nogil:
+    # 1-D
+    free(buf.remaining_point_indices)
+    free(buf.included_composition_indices)
+    free(buf.best_guess_simplex)
+    free(buf.free_chempot_indices)
+    free(buf.candidate_simplex)
+    free(buf.int_tmp)
+    free(buf.candidate_potentials)
+    free(buf.smallest_fractions)
+    free(buf.driving_forces)
+    free(buf.compact_energies)
+    free(buf.all_potentials)
+    # 2-D
+    free(buf.trial_simplices)
+    free(buf.fractions)
+    free(buf.f_contig_trial)
+    free(buf.f_candidate_tieline)
+    free(buf.compact_compositions)
+    # 3-D
+    free(buf.f_trial_matrix)
+    memset(buf, 0, sizeof(HyperplaneBuffers))
+
+
+cdef class HyperplaneWorkspace:
+    """
+    Scratch space for hyperplane(), so that repeated calls do not allocate.
+    Buffers grow as needed; the constructor arguments only set their initial size.
+    A workspace must not be shared by concurrent calls.
+
+    Parameters
+    ----------
+    num_points : int
+        Number of points in the energy surface sample.
+    num_components : int
+        Number of components of the system.
+    """
+    def __cinit__(self, int num_points=0, int num_components=0):
+        memset(&self.buffers, 0, sizeof(HyperplaneBuffers))
+        _reserve_buffers(&self.buffers, num_points, num_components, num_components)
+
+    def __dealloc__(self):
+        _free_buffers(&self.buffers)
+
+
 @cython.boundscheck(False)
-cpdef double hyperplane(double[:,::1] compositions,
-                        double[::1] energies,
-                        double[::1] composition,
+cdef double _simplex_min_fraction(const double[:,::1] compositions, const int[::1] simplex,
+                                  int* included_composition_indices, const double[::1] composition,
+                                  double total_moles, int simplex_size, double* matrix, double* fractions,
+                                  int* ipiv) noexcept nogil:
+    "Smallest phase fraction of the target composition in the given simplex, or -1e19 if it is degenerate."
+    cdef int comp_idx, simplex_idx, ici
+    for comp_idx in range(simplex_size):
+        ici = included_composition_indices[comp_idx]
+        for simplex_idx in range(simplex_size):
+            if ici >= 0:
+                matrix[comp_idx + simplex_idx*simplex_size] = compositions[simplex[simplex_idx], ici]
+            else:
+                # ici = -1, refers to N=1 condition
+                matrix[comp_idx + simplex_idx*simplex_size] = 1
+        if ici >= 0:
+            fractions[comp_idx] = composition[ici]
+        else:
+            fractions[comp_idx] = total_moles
+    solve(matrix, simplex_size, fractions, ipiv)
+    return _min(fractions, simplex_size)
+
+
+@cython.boundscheck(False)
+cpdef double hyperplane(const double[:,::1] compositions,
+                        const double[::1] energies,
+                        const double[::1] composition,
                         double[::1] chemical_potentials,
                         double total_moles,
-                        size_t[::1] fixed_chempot_indices,
-                        size_t[::1] fixed_comp_indices,
+                        const size_t[::1] fixed_chempot_indices,
+                        const size_t[::1] fixed_comp_indices,
                         double[::1] result_fractions,
-                        int[::1] result_simplex) nogil except *:
+                        int[::1] result_simplex,
+                        HyperplaneWorkspace workspace=None,
+                        const int[::1] initial_simplex=None,
+                        int[::1] statistics=None) except * nogil:
     """
     Find chemical potentials which approximate the tangent hyperplane
     at the given composition.
@@ -97,6 +209,17 @@ cpdef double hyperplane(double[:,::1] compositions,
     result_simplex : ndarray
         Energies of the points making up the hyperplane simplex. Shape of (P,).
         Will be overwritten. Output*result_fractions sums to out_energy (return value).
+    workspace : HyperplaneWorkspace, optional
+        Scratch space reused across calls. If not specified, temporary buffers are allocated.
+    initial_simplex : ndarray, optional
+        Indices of points to start from instead of the fictitious points, e.g., the
+        result_simplex of a neighboring condition. It is only used if the target composition
+        lies inside it; otherwise, or if it is shorter than the simplex, it is ignored.
+        The chemical potentials are determined by the simplex, so no separate guess is needed.
+    statistics : ndarray, optional
+        If specified, overwritten with the number of iterations, the number of singular
+        linear solves, the number of points left after the first pruning pass, and the
+        number of points left at the end, in the order of HYPERPLANE_STATISTICS. Shape of (4,).
 
     Returns
     -------
@@ -124,21 +247,35 @@ cpdef double hyperplane(double[:,::1] compositions,
     cdef int min_df
     cdef int max_iterations = 1000
     cdef int iterations = 0
+    cdef int singular_solves = 0
+    cdef int points_after_first_pass = num_points
     cdef int idx, ici, comp_idx, simplex_idx, trial_idx, chempot_idx
     cdef bint tmp3
     cdef bint skip_index = False
     cdef double lowest_df = 0
     cdef double out_energy = 0
+    cdef HyperplaneBuffers local_buffers
+    cdef HyperplaneBuffers* buf
+    if workspace is None:
+        memset(&local_buffers, 0, sizeof(HyperplaneBuffers))
+        buf = &local_buffers
+    else:
+        buf = &workspace.buffers
+    _reserve_buffers(buf, num_points, num_components, simplex_size)
     # 1-D
-    cdef int* remaining_point_indices = <int*>malloc(num_points * sizeof(int))
+    cdef int* remaining_point_indices = buf.remaining_point_indices
     for i in range(num_points):
         remaining_point_indices[i] = i
+    # Remaining points, contiguous, for the driving force update. All points remain at first,
+    # so the inputs are used directly until the first pruning pass compacts them into the buffers.
+    cdef double* compact_compositions = <double*>&compositions[0, 0]
+    cdef double* compact_energies = <double*>&energies[0]
     # composition index of -1 indicates total number of moles, i.e., N=1 condition
-    cdef int* included_composition_indices = <int*>malloc((fixed_comp_indices.shape[0] + 1) * sizeof(int))
+    cdef int* included_composition_indices = buf.included_composition_indices
     for i in range(fixed_comp_indices.shape[0]):
         included_composition_indices[i] = fixed_comp_indices[i]
     included_composition_indices[fixed_comp_indices.shape[0]] = -1
-    cdef int* best_guess_simplex = <int*>malloc(simplex_size * sizeof(int))
+    cdef int* best_guess_simplex = buf.best_guess_simplex
     for i in range(num_components):
         skip_index = False
         for j in range(num_fixed_chempots):
@@ -149,25 +286,37 @@ cpdef double hyperplane(double[:,::1] compositions,
         else:
             best_guess_simplex[fixed_index] = i
             fixed_index += 1
-    cdef int* free_chempot_indices = <int*>malloc(simplex_size * sizeof(int))
-    cdef int* candidate_simplex = <int*>malloc(simplex_size * sizeof(int))
+    cdef int* free_chempot_indices = buf.free_chempot_indices
+    cdef int* candidate_simplex = buf.candidate_simplex
     for i in range(simplex_size):
         free_chempot_indices[i] = best_guess_simplex[i]
         candidate_simplex[i] = best_guess_simplex[i]
-    cdef int* int_tmp = <int*>malloc(simplex_size * sizeof(int)) # np.empty(simplex_size, dtype=np.int32)
-    cdef double* candidate_potentials = <double*>malloc(simplex_size * sizeof(double)) # np.empty(simplex_size)
-    cdef double* smallest_fractions = <double*>malloc(simplex_size * sizeof(double)) # np.empty(simplex_size)
-    cdef double* driving_forces = <double*>malloc(num_points * sizeof(double)) # np.empty(compositions.shape[0])
+    cdef int* int_tmp = buf.int_tmp # np.empty(simplex_size, dtype=np.int32)
+    # Warm start: any simplex containing the target composition is a valid starting point
+    if initial_simplex is not None and initial_simplex.shape[0] >= simplex_size:
+        if _simplex_min_fraction(compositions, initial_simplex, included_composition_indices, composition,
+                                 total_moles, simplex_size, buf.f_contig_trial, buf.fractions, int_tmp) >= 0:
+            for i in range(simplex_size):
+                best_guess_simplex[i] = initial_simplex[i]
+                candidate_simplex[i] = best_guess_simplex[i]
+    cdef double* candidate_potentials = buf.candidate_potentials # np.empty(simplex_size)
+    cdef double* smallest_fractions = buf.smallest_fractions # np.empty(simplex_size)
+    cdef double* driving_forces = buf.driving_forces # np.empty(compositions.shape[0])
+    cdef double* all_potentials = buf.all_potentials # np.empty(num_components)
+    cdef char transpose = b'T'
+    cdef int inc = 1
+    cdef double minus_one = -1
+    cdef double one = 1
     # 2-D
-    cdef int* trial_simplices = <int*>malloc(simplex_size * simplex_size * sizeof(int)) # np.empty((simplex_size, simplex_size), dtype=np.int32)
-    cdef double* fractions = <double*>malloc(simplex_size * simplex_size * sizeof(double)) # np.empty((simplex_size, simplex_size))
+    cdef int* trial_simplices = buf.trial_simplices # np.empty((simplex_size, simplex_size), dtype=np.int32)
+    cdef double* fractions = buf.fractions # np.empty((simplex_size, simplex_size))
     for i in range(simplex_size):
         for j in range(simplex_size):
             trial_simplices[i*simplex_size + j] = best_guess_simplex[j]
-    cdef double* f_contig_trial = <double*>malloc(simplex_size * simplex_size * sizeof(double)) # np.empty((simplex_size, simplex_size), order='F')
-    cdef double* f_candidate_tieline = <double*>malloc(simplex_size * simplex_size * sizeof(double)) # np.empty((simplex_size, simplex_size), order='F')
+    cdef double* f_contig_trial = buf.f_contig_trial # np.empty((simplex_size, simplex_size), order='F')
+    cdef double* f_candidate_tieline = buf.f_candidate_tieline # np.empty((simplex_size, simplex_size), order='F')
     # 3-D
-    cdef double* f_trial_matrix = <double*>malloc(simplex_size * simplex_size * simplex_size * sizeof(double)) # np.empty((simplex_size, simplex_size, simplex_size), order='F')
+    cdef double* f_trial_matrix = buf.f_trial_matrix # np.empty((simplex_size, simplex_size, simplex_size), order='F')
 
 
     while iterations < max_iterations:
@@ -195,7 +344,7 @@ cpdef double hyperplane(double[:,::1] compositions,
                 else:
                     # ici = -1, refers to N=1 condition
                     fractions[trial_idx*simplex_size + simplex_idx] = total_moles
-            solve(f_contig_trial, simplex_size, &fractions[trial_idx*simplex_size], int_tmp)
+            singular_solves += solve(f_contig_trial, simplex_size, &fractions[trial_idx*simplex_size], int_tmp)
             smallest_fractions[trial_idx] = _min(&fractions[trial_idx*simplex_size], simplex_size)
 
         # Choose simplex with the largest smallest-fraction
@@ -214,19 +363,19 @@ cpdef double hyperplane(double[:,::1] compositions,
             for ici in range(fixed_chempot_indices.shape[0]):
                 chempot_idx = fixed_chempot_indices[ici]
                 candidate_potentials[i] -= chemical_potentials[chempot_idx] * compositions[idx, chempot_idx]
-        solve(f_candidate_tieline, simplex_size, candidate_potentials, int_tmp)
+        singular_solves += solve(f_candidate_tieline, simplex_size, candidate_potentials, int_tmp)
         if candidate_potentials[0] == -1e19:
             break
-        for i in range(num_points):
-            driving_forces[i] = energies[remaining_point_indices[i]]
+        # driving_forces = compact_energies - compact_compositions @ all_potentials
         for ici in range(simplex_size):
-            chempot_idx = free_chempot_indices[ici]
-            for idx in range(num_points):
-                driving_forces[idx] -= candidate_potentials[ici] * compositions[remaining_point_indices[idx], chempot_idx]
+            all_potentials[free_chempot_indices[ici]] = candidate_potentials[ici]
         for ici in range(fixed_chempot_indices.shape[0]):
             chempot_idx = fixed_chempot_indices[ici]
-            for idx in range(num_points):
-                driving_forces[idx] -= chemical_potentials[chempot_idx] * compositions[remaining_point_indices[idx], chempot_idx]
+            all_potentials[chempot_idx] = chemical_potentials[chempot_idx]
+        for i in range(num_points):
+            driving_forces[i] = compact_energies[i]
+        cython_blas.dgemv(&transpose, &num_components, &num_points, &minus_one, compact_compositions,
+                          &num_components, all_potentials, &inc, &one, driving_forces, &inc)
         for i in range(simplex_size):
             best_guess_simplex[i] = candidate_simplex[i]
         for i in range(simplex_size):
@@ -240,11 +389,18 @@ cpdef double hyperplane(double[:,::1] compositions,
         for i in range(num_points):
             if driving_forces[i] < 1.0:
                 remaining_point_indices[ici] = remaining_point_indices[i]
+                buf.compact_energies[ici] = compact_energies[i]
+                for j in range(num_components):
+                    buf.compact_compositions[ici*num_components + j] = compact_compositions[i*num_components + j]
                 if driving_forces[i] < lowest_df:
                     lowest_df = driving_forces[i]
                     min_df = ici
                 ici += 1
         num_points = ici
+        if iterations == 1:
+            points_after_first_pass = num_points
+        compact_compositions = buf.compact_compositions
+        compact_energies = buf.compact_energies
 
         # Trial simplices will be the current simplex with each vertex
         #     replaced by the trial point
@@ -268,23 +424,176 @@ cpdef double hyperplane(double[:,::1] compositions,
     # Hack to enforce Gibbs phase rule, shape of result is comp+1, shape of hyperplane is comp
     result_fractions[simplex_size:] = 0.0
     result_simplex[simplex_size:] = 0
+    if statistics is not None and statistics.shape[0] >= 4:
+        statistics[0] = iterations
+        statistics[1] = singular_solves
+        statistics[2] = points_after_first_pass
+        statistics[3] = num_points
 
-    # 1-D
-    free(remaining_point_indices)
-    free(included_composition_indices)
-    free(best_guess_simplex)
-    free(free_chempot_indices)
-    free(candidate_simplex)
-    free(int_tmp)
-    free(candidate_potentials)
-    free(smallest_fractions)
-    free(driving_forces)
-    # 2-D
-    free(trial_simplices)
-    free(fractions)
-    free(f_contig_trial)
-    free(f_candidate_tieline)
-    # 3-D
-    free(f_trial_matrix)
+    if workspace is None:
+        _free_buffers(&local_buffers)
 
     return out_energy
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef void _hull_copy_out(Py_ssize_t k, const double[:, :, ::1] grid_X, const double[:, ::1] grid_GM,
+                         const np.int16_t[:, ::1] grid_phase_ids, const np.int64_t[:, ::1] grid_Y_offsets,
+                         const np.int32_t[:, ::1] grid_Y_dof, const double[::1] grid_Y_packed, Py_ssize_t row,
+                         double[::1] result_GM, double[:, ::1] result_NP, int[:, ::1] result_points,
+                         double[:, :, ::1] result_X, double[:, :, ::1] result_Y,
+                         np.int16_t[:, ::1] result_phase_ids) noexcept nogil:
+    cdef int num_comps = grid_X.shape[2]
+    cdef int num_vertices = result_NP.shape[1]
+    cdef int vertex, comp_idx, dof_idx, point, dof
+    cdef np.int64_t offset
+    cdef bint has_fake = False
+    cdef double new_energy = 0
+    cdef double molesum = 0
+    # Copy phase values out
+    for vertex in range(num_vertices):
+        if vertex >= num_comps:
+            result_phase_ids[k, vertex] = -1
+            continue
+        point = result_points[k, vertex]
+        result_phase_ids[k, vertex] = grid_phase_ids[row, point]
+        has_fake = has_fake or (grid_phase_ids[row, point] == _FAKE_PHASE_ID)
+        for comp_idx in range(num_comps):
+            result_X[k, vertex, comp_idx] = grid_X[row, point, comp_idx]
+        offset = grid_Y_offsets[row, point]
+        dof = grid_Y_dof[row, point]
+        for dof_idx in range(result_Y.shape[2]):
+            if dof_idx < dof:
+                result_Y[k, vertex, dof_idx] = grid_Y_packed[offset + dof_idx]
+            else:
+                result_Y[k, vertex, dof_idx] = NAN
+    # Special case: Sometimes fictitious points slip into the result
+    if has_fake:
+        for vertex in range(num_vertices):
+            if result_phase_ids[k, vertex] == _FAKE_PHASE_ID:
+                result_phase_ids[k, vertex] = -1
+                for comp_idx in range(num_comps):
+                    result_X[k, vertex, comp_idx] = NAN
+                for dof_idx in range(result_Y.shape[2]):
+                    result_Y[k, vertex, dof_idx] = NAN
+                result_NP[k, vertex] = NAN
+            else:
+                new_energy += result_NP[k, vertex] * grid_GM[row, result_points[k, vertex]]
+                molesum += result_NP[k, vertex]
+        result_GM[k] = new_energy / molesum
+
+
+@cython.boundscheck(False)
+@cython.wraparound(False)
+cdef void _hull_condition(Py_ssize_t k, const double[:, :, ::1] grid_X, const double[:, ::1] grid_GM,
+                          const np.int16_t[:, ::1] grid_phase_ids, const np.int64_t[:, ::1] grid_Y_offsets,
+                          const np.int32_t[:, ::1] grid_Y_dof, const double[::1] grid_Y_packed,
+                          const np.intp_t[::1] statevar_rows, const double[:, ::1] comp_values,
+                          const np.intp_t[::1] comp_rows, const double[:, ::1] pot_values,
+                          const np.intp_t[::1] pot_rows, const size_t[::1] pot_conds_indices,
+                          const size_t[::1] comp_conds_indices, double total_moles,
+                          double[::1] result_GM, double[:, ::1] result_MU, double[:, ::1] result_NP,
+                          int[:, ::1] result_points, double[:, :, ::1] result_X, double[:, :, ::1] result_Y,
+                          np.int16_t[:, ::1] result_phase_ids, const int[::1] initial_simplex,
+                          int[::1] statistics, HyperplaneWorkspace workspace) noexcept nogil:
+    cdef Py_ssize_t row = statevar_rows[k]
+    cdef int comp_idx
+    for comp_idx in range(result_MU.shape[1]):
+        result_MU[k, comp_idx] = 0
+    for comp_idx in range(pot_conds_indices.shape[0]):
+        result_MU[k, pot_conds_indices[comp_idx]] = pot_values[pot_rows[k], comp_idx]
+    result_GM[k] = hyperplane(grid_X[row], grid_GM[row], comp_values[comp_rows[k]], result_MU[k], total_moles,
+                              pot_conds_indices, comp_conds_indices, result_NP[k], result_points[k], workspace,
+                              initial_simplex, statistics)
+    _hull_copy_out(k, grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed, row,
+                   result_GM, result_NP, result_points, result_X, result_Y, result_phase_ids)
+
+
+def hull_conditions(const double[:, :, ::1] grid_X, const double[:, ::1] grid_GM,
+                    const np.int16_t[:, ::1] grid_phase_ids, const np.int64_t[:, ::1] grid_Y_offsets,
+                    const np.int32_t[:, ::1] grid_Y_dof, const double[::1] grid_Y_packed,
+                    const np.intp_t[::1] statevar_rows, const double[:, ::1] comp_values,
+                    const np.intp_t[::1] comp_rows, const double[:, ::1] pot_values,
+                    const np.intp_t[::1] pot_rows, const size_t[::1] pot_conds_indices,
+                    const size_t[::1] comp_conds_indices, double total_moles,
+                    double[::1] result_GM, double[:, ::1] result_MU, double[:, ::1] result_NP,
+                    int[:, ::1] result_points, double[:, :, ::1] result_X, double[:, :, ::1] result_Y,
+                    np.int16_t[:, ::1] result_phase_ids, const np.intp_t[::1] seed_conditions,
+                    Py_ssize_t start, Py_ssize_t stop, int[:, ::1] result_statistics=None):
+    """
+    Find the lower convex hull at the flattened conditions start <= k < stop, without holding the GIL.
+    This is the compiled driver loop of lower_convex_hull; arrays are flattened over conditions (K)
+    and over the state variable slices of the grid (S).
+
+    Parameters
+    ----------
+    grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof : ndarray
+        Grid variables of shape (S, M, ...), where M is the number of points.
+    grid_Y_packed : ndarray
+        Packed site fractions of the grid.
+    statevar_rows : ndarray
+        Grid slice of each condition. Shape (K,).
+    comp_values, pot_values : ndarray
+        Target compositions and fixed chemical potentials, with one row per combination of conditions.
+    comp_rows, pot_rows : ndarray
+        Row of comp_values and pot_values for each condition. Shape (K,).
+    pot_conds_indices, comp_conds_indices : ndarray
+        See hyperplane().
+    total_moles : double
+        Total number of moles in the system.
+    result_GM, result_MU, result_NP, result_points, result_X, result_Y : ndarray
+        Results of shape (K, ...). Will be overwritten.
+    result_phase_ids : ndarray
+        Grid phase code of each vertex, or -1 for no phase. Shape (K, P). Will be overwritten.
+    seed_conditions : ndarray
+        Condition whose simplex is used as the initial simplex of each condition, or -1 to start
+        from the fictitious points. Seeds outside of [start, k) are ignored. Shape (K,).
+    start, stop : int
+        Range of conditions to solve.
+    result_statistics : ndarray, optional
+        If specified, the hyperplane() statistics of each condition, see HYPERPLANE_STATISTICS.
+        Shape (K, 4). Will be overwritten.
+    """
+    cdef Py_ssize_t k, seed, initial_simplex_size
+    cdef Py_ssize_t simplex_size = grid_X.shape[2] - pot_conds_indices.shape[0]
+    cdef HyperplaneWorkspace workspace = HyperplaneWorkspace(grid_GM.shape[1], grid_X.shape[2])
+    cdef bint collect_statistics = result_statistics is not None
+    if not collect_statistics:
+        # Zero-length rows are ignored by hyperplane()
+        result_statistics = np.empty((1, 0), dtype=np.int32)
+    with nogil:
+        for k in range(start, stop):
+            seed = seed_conditions[k]
+            # An empty initial simplex is ignored by hyperplane()
+            if seed < start or seed >= k:
+                seed = k
+                initial_simplex_size = 0
+            else:
+                initial_simplex_size = simplex_size
+            _hull_condition(k, grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed,
+                            statevar_rows, comp_values, comp_rows, pot_values, pot_rows,
+                            pot_conds_indices, comp_conds_indices, total_moles,
+                            result_GM, result_MU, result_NP, result_points, result_X, result_Y,
+                            result_phase_ids, result_points[seed, :initial_simplex_size],
+                            result_statistics[k if collect_statistics else 0], workspace)
+
+
+def hull_copy_out(const double[:, :, ::1] grid_X, const double[:, ::1] grid_GM,
+                  const np.int16_t[:, ::1] grid_phase_ids, const np.int64_t[:, ::1] grid_Y_offsets,
+                  const np.int32_t[:, ::1] grid_Y_dof, const double[::1] grid_Y_packed,
+                  const np.intp_t[::1] statevar_rows, double[::1] result_GM, double[:, ::1] result_NP,
+                  int[:, ::1] result_points, double[:, :, ::1] result_X, double[:, :, ::1] result_Y,
+                  np.int16_t[:, ::1] result_phase_ids, const np.intp_t[::1] conditions):
+    """
+    Copy the grid values of already-solved simplices into the results, and clear fictitious
+    vertices, as hull_conditions() does after each hyperplane() call. Only the given
+    conditions are copied. See hull_conditions() for the meaning of the other arguments.
+    """
+    cdef Py_ssize_t idx, k
+    with nogil:
+        for idx in range(conditions.shape[0]):
+            k = conditions[idx]
+            _hull_copy_out(k, grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed,
+                           statevar_rows[k], result_GM, result_NP, result_points, result_X, result_Y,
+                           result_phase_ids)
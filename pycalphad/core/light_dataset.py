@@ -1,5 +1,7 @@
 """Defines a class for internally representing arrays used in equilibrium calculations"""
 
+import json
+import os
 import numpy as np
 from xarray import Dataset
 
@@ -94,3 +96,63 @@ class LightDataset:
     def add_variable(self, var, coord, value):
         self.data_vars[var] = (coord, value)
         setattr(self, var, value)
+
+
+def create_memmap_dataset(directory, data_vars, coords=None, attrs=None):
+    """
+    Create a LightDataset whose data variables are memory-mapped .npy files.
+
+    Parameters
+    ----------
+    directory : str
+        Existing directory in which one '<name>.npy' file per data variable
+        and a 'dataset.json' file describing dimensions and coordinates are written.
+    data_vars : dict
+        Dictionary of {Variable: (Dimensions, Shape, dtype)}
+    coords : dict, optional
+        Mapping of {Dimension: Values}
+    attrs : dict, optional
+
+    Returns
+    -------
+    LightDataset
+
+    Notes
+    -----
+    Values written to the arrays reach the files without any explicit save step,
+    so partial results remain readable with `open_memmap_dataset` if the process
+    writing them is interrupted.
+    """
+    coords = coords or dict()
+    attrs = attrs or dict()
+    metadata = {'dims': {var: list(dims) for var, (dims, _, _) in data_vars.items()},
+                'coords': {coord: np.asarray(values).tolist() for coord, values in coords.items()},
+                'attrs': attrs}
+    with open(os.path.join(directory, 'dataset.json'), 'w') as fp:
+        json.dump(metadata, fp)
+    arrays = {var: (dims, np.lib.format.open_memmap(os.path.join(directory, var + '.npy'), mode='w+',
+                                                    dtype=dtype, shape=shape))
+              for var, (dims, shape, dtype) in data_vars.items()}
+    return LightDataset(arrays, coords=coords, attrs=attrs)
+
+
+def open_memmap_dataset(directory, mode='r'):
+    """
+    Open a LightDataset previously created by `create_memmap_dataset`.
+
+    Parameters
+    ----------
+    directory : str
+    mode : str, optional
+        Memory-map mode of the data variables, e.g., 'r' (default) or 'r+'.
+
+    Returns
+    -------
+    LightDataset
+    """
+    with open(os.path.join(directory, 'dataset.json')) as fp:
+        metadata = json.load(fp)
+    arrays = {var: (dims, np.load(os.path.join(directory, var + '.npy'), mmap_mode=mode))
+              for var, dims in metadata['dims'].items()}
+    coords = {coord: np.asarray(values) for coord, values in metadata['coords'].items()}
+    return LightDataset(arrays, coords=coords, attrs=metadata['attrs'])
@@ -3,13 +3,195 @@ The lower_convex_hull module handles geometric calculations associated with
 equilibrium calculation.
 """
 from pycalphad.core.cartesian import cartesian
-from pycalphad.core.constants import MIN_SITE_FRACTION
-from .hyperplane import hyperplane
+from pycalphad.core.constants import MIN_SITE_FRACTION, GRID_PRUNING_MARGIN, FAKE_PHASE_ID
+from pycalphad.core.light_dataset import LightDataset
+from .hyperplane import hull_conditions, hull_copy_out, HYPERPLANE_STATISTICS
+from scipy.spatial import ConvexHull
+from scipy.spatial.qhull import QhullError
 import numpy as np
 import itertools
 
 
-def lower_convex_hull(global_grid, state_variables, result_array):
+def prune_grid(global_grid, margin=GRID_PRUNING_MARGIN):
+    """
+    Remove points which cannot be on the lower convex hull from each state variable
+    slice of a sampled energy surface.
+
+    Parameters
+    ----------
+    global_grid : LightDataset
+        A sample of the energy surface of the system, as returned by
+        calculate(..., fake_points=True, to_xarray=False).
+    margin : float, optional
+        Points whose energy is more than this far above the reference hyperplane are removed.
+
+    Returns
+    -------
+    LightDataset
+        Sample of the energy surface with a (possibly) shorter 'points' dimension.
+
+    Notes
+    -----
+    The reference hyperplane of each slice passes through the lowest energy point at each
+    pure-component vertex, or through the fictitious point if no real point is pure.
+    The lower convex hull is never above that hyperplane, so any point above it cannot be part
+    of a starting point. Fictitious points are always kept at the front of the grid, because
+    hyperplane() uses them as the initial simplex. Each slice may keep a different number of
+    points; shorter slices are padded with copies of the first fictitious point. Site fractions
+    in 'Y_packed' that no slice keeps are removed, and 'Y_offsets' is rewritten to match.
+    """
+    grid_GM = global_grid.GM
+    grid_X = global_grid.X
+    num_comps = grid_X.shape[-1]
+    num_points = grid_GM.shape[-1]
+    slice_shape = grid_GM.shape[:-1]
+    num_slices = int(np.prod(slice_shape))
+    flat_GM = grid_GM.reshape(num_slices, num_points)
+    flat_X = grid_X.reshape(num_slices, num_points, num_comps)
+    # One component at a time, so no temporary is as large as X
+    pure_energies = np.empty((num_slices, num_comps))
+    for comp_idx in range(num_comps):
+        pure_energies[:, comp_idx] = np.where(flat_X[..., comp_idx] > 1 - 1e-6, flat_GM, np.inf).min(axis=-1)
+    reference_energies = np.einsum('ijk,ik->ij', flat_X, pure_energies)
+    # Comparisons against NaN are False, so undefined points are conservatively kept
+    keep = ~(flat_GM > reference_energies + margin)
+    keep[:, :num_comps] = True
+    num_kept = keep.sum(axis=-1)
+    max_kept = int(num_kept.max())
+    if max_kept == num_points:
+        return global_grid
+    # Stable sort keeps the original point order within each slice
+    kept_indices = np.argsort(~keep, axis=-1, kind='stable')[:, :max_kept]
+    kept_indices[np.arange(max_kept)[np.newaxis, :] >= num_kept[:, np.newaxis]] = 0
+    slice_indices = np.arange(num_slices)[:, np.newaxis]
+
+    data_vars = {}
+    for var, (dims, values) in global_grid.data_vars.items():
+        if 'points' not in dims or dims.index('points') != len(slice_shape):
+            data_vars[var] = (dims, values)
+            continue
+        trailing_shape = values.shape[len(slice_shape)+1:]
+        flat_values = values.reshape((num_slices, num_points) + trailing_shape)
+        pruned_values = flat_values[slice_indices, kept_indices]
+        data_vars[var] = (dims, pruned_values.reshape(slice_shape + (max_kept,) + trailing_shape))
+    if 'Y_packed' in data_vars:
+        packed_dims, packed = data_vars['Y_packed']
+        offsets_dims, offsets = data_vars['Y_offsets']
+        packed, offsets = _compact_packed_site_fractions(packed, offsets, data_vars['Y_dof'][1])
+        data_vars['Y_packed'] = (packed_dims, packed)
+        data_vars['Y_offsets'] = (offsets_dims, offsets)
+    return LightDataset(data_vars, coords=global_grid.coords, attrs=global_grid.attrs)
+
+
+def _compact_packed_site_fractions(packed, offsets, dofs):
+    """
+    Copy the site fraction blocks referenced by 'offsets' and 'dofs' into a new packed buffer,
+    and return it with the offsets of each point into it. Points sharing a block still share it.
+    Points without site fractions get an offset of zero.
+    """
+    has_dof = dofs > 0
+    block_starts, block_index = np.unique(offsets[has_dof], return_index=True)
+    block_dofs = dofs[has_dof][block_index].astype(np.int64)
+    new_starts = np.cumsum(block_dofs) - block_dofs
+    gather_indices = np.repeat(block_starts - new_starts, block_dofs) + np.arange(block_dofs.sum())
+    new_offsets = np.zeros(offsets.shape, dtype=offsets.dtype)
+    new_offsets[has_dof] = new_starts[np.searchsorted(block_starts, offsets[has_dof])]
+    return np.asarray(packed)[gather_indices], new_offsets
+
+
+class LowerHullIndex(object):
+    """
+    Lower convex hull facets of each state variable slice of a sampled energy surface,
+    for answering many composition conditions without iterating hyperplane().
+
+    The facets are computed once per slice with Qhull. The lower hull is the largest of the
+    facet hyperplanes at any composition, so each composition is located by evaluating every
+    facet there. This is only worthwhile for systems with few components.
+
+    Fictitious points are left out of the hull, because their very large energies would swamp
+    the precision of Qhull. Compositions outside of the real points are not covered.
+
+    Parameters
+    ----------
+    global_grid : LightDataset
+        A sample of the energy surface of the system, as returned by
+        calculate(..., fake_points=True, to_xarray=False).
+
+    Attributes
+    ----------
+    potentials : list of ndarray
+        Chemical potentials of the lower facets of each slice. Shape (F, N) per slice.
+    simplices : list of ndarray
+        Grid point indices of the vertices of the lower facets of each slice. Shape (F, N) per slice.
+        Both are None for slices where the hull could not be computed, e.g., for degenerate samples.
+    """
+    max_components = 3
+
+    def __init__(self, global_grid):
+        num_comps = global_grid.X.shape[-1]
+        num_points = global_grid.GM.shape[-1]
+        if not 2 <= num_comps <= self.max_components:
+            raise ValueError('Hull index requires between 2 and {} components'.format(self.max_components))
+        self.grid_shape = global_grid.GM.shape
+        grid_X = global_grid.X.reshape(-1, num_points, num_comps)
+        grid_GM = global_grid.GM.reshape(-1, num_points)
+        grid_phase_ids = global_grid.Phase_id.reshape(-1, num_points)
+        self.potentials = []
+        self.simplices = []
+        for compositions, energies, phase_ids in zip(grid_X, grid_GM, grid_phase_ids):
+            facets = self._lower_facets(compositions, energies, phase_ids != FAKE_PHASE_ID)
+            self.potentials.append(facets[0] if facets is not None else None)
+            self.simplices.append(facets[1] if facets is not None else None)
+
+    @staticmethod
+    def _lower_facets(compositions, energies, is_real):
+        defined = np.nonzero(is_real & np.isfinite(energies) & np.all(np.isfinite(compositions), axis=-1))[0]
+        # The last component is dependent; the hull lives in the space of the others plus energy
+        points = np.column_stack((compositions[defined, :-1], energies[defined]))
+        try:
+            hull = ConvexHull(points)
+        except (QhullError, ValueError):
+            return None
+        # Outward normals of lower facets point towards lower energy
+        normals = hull.equations[:, :-1]
+        lower = normals[:, -1] < -1e-12 * np.linalg.norm(normals, axis=-1)
+        simplices = defined[hull.simplices[lower]]
+        vertex_compositions = compositions[simplices]
+        try:
+            # mu . x = G at every vertex of a facet
+            potentials = np.linalg.solve(vertex_compositions, energies[simplices])
+        except np.linalg.LinAlgError:
+            return None
+        return potentials, simplices.astype(np.int32)
+
+    def locate(self, row, compositions, chunk_size=1024):
+        """
+        Find the lower hull facet at each composition of one state variable slice.
+
+        Parameters
+        ----------
+        row : int
+            Index of the slice in the flattened state variable dimensions of the grid.
+        compositions : ndarray
+            Mole fractions of all components. Shape (K, N).
+        chunk_size : int, optional
+            Number of compositions evaluated against all facets at once.
+
+        Returns
+        -------
+        ndarray
+            Index of the facet of each composition in potentials[row] and simplices[row]. Shape (K,).
+        """
+        facet_potentials = self.potentials[row]
+        facets = np.empty(compositions.shape[0], dtype=np.intp)
+        for start in range(0, compositions.shape[0], chunk_size):
+            chunk = compositions[start:start+chunk_size]
+            facets[start:start+chunk_size] = np.argmax(np.dot(chunk, facet_potentials.T), axis=-1)
+        return facets
+
+
+def lower_convex_hull(global_grid, state_variables, result_array, executor=None, conditions_per_task=64,
+                      warm_start=True, hull_index=None, diagnostics=False):
     """
     Find the simplices on the lower convex hull satisfying the specified
     conditions in the result array.
@@ -23,6 +205,24 @@ def lower_convex_hull(global_grid, state_variables, result_array):
     result_array : Dataset
         This object will be modified!
         Coordinates correspond to conditions axes.
+    executor : concurrent.futures.Executor, optional
+        Thread-based executor used to solve blocks of conditions concurrently.
+        The result does not depend on the executor.
+    conditions_per_task : int, optional
+        Number of conditions solved by each task submitted to 'executor'.
+        It is rounded up to a whole number of rows of the last condition axis.
+    warm_start : bool, optional
+        If True (the default), each condition starts from the simplex found for the previous
+        condition along the last condition axis, instead of from the fictitious points.
+    hull_index : bool or LowerHullIndex, optional
+        If True, or a LowerHullIndex built from global_grid, conditions are answered by locating
+        them on precomputed hull facets instead of by iterating hyperplane(). It is only used for
+        binary and ternary systems with composition conditions. Conditions the hull does not
+        cover, e.g., outside of the sampled compositions, still use hyperplane().
+    diagnostics : bool, optional
+        If True, the hyperplane() statistics of each condition (see HYPERPLANE_STATISTICS) are
+        added to result_array as integer variables named 'hull_' followed by the statistic.
+        They are zero for conditions that were not solved by hyperplane().
 
     Returns
     -------
@@ -70,79 +270,172 @@ def lower_convex_hull(global_grid, state_variables, result_array):
 
     if len(pot_conds) > 0:
         cart_pot_values = cartesian([result_array.coords[cond] for cond in pot_conds])
+    else:
+        cart_pot_values = np.empty((1, 0))
 
-    #result_array['Phase'] = force_indep_align(result_array.Phase)
-    # factored out via profiling
-    result_array_GM_values = result_array.GM
+    # Flatten the conditions and the state variable slices of the grid, so the compiled
+    # driver loop only has to look up one row of each for every condition
     result_array_GM_dims = result_array.data_vars['GM'][0]
-    result_array_points_values = result_array.points
-    result_array_MU_values = result_array.MU
-    result_array_NP_values = result_array.NP
-    result_array_X_values = result_array.X
-    result_array_Y_values = result_array.Y
-    result_array_Phase_values = result_array.Phase
-    global_grid_GM_values = global_grid.GM
-    global_grid_X_values = global_grid.X
-    global_grid_Y_values = global_grid.Y
-    global_grid_Phase_values = global_grid.Phase
+    conds_shape = result_array.GM.shape
+    num_conds = int(np.prod(conds_shape))
     num_comps = len(result_array.coords['component'])
+    num_points = global_grid.GM.shape[-1]
+    grid_slice_shape = global_grid.GM.shape[:-1]
+    multi_indices = np.indices(conds_shape).reshape(len(conds_shape), num_conds)
+    # Free state variables always use the first slice of the grid
+    indep_idx = tuple(multi_indices[result_array_GM_dims.index(str(sv))]
+                      if str(sv) in result_array_GM_dims else np.zeros(num_conds, dtype=np.intp)
+                      for sv in state_variables)
+    statevar_rows = np.ravel_multi_index(indep_idx, grid_slice_shape) if len(indep_idx) > 0 \
+        else np.zeros(num_conds, dtype=np.intp)
+
+    def condition_rows(conds):
+        if len(conds) == 0:
+            return np.zeros(num_conds, dtype=np.intp)
+        return np.ravel_multi_index(tuple(multi_indices[result_array_GM_dims.index(cond)] for cond in conds),
+                                    tuple(len(result_array.coords[cond]) for cond in conds))
+
+    # Built once here, since every hull_conditions call below shares them
+    comp_values = np.ascontiguousarray(comp_values)
+    comp_rows = condition_rows(comp_conds)
+    cart_pot_values = np.ascontiguousarray(cart_pot_values, dtype=np.float64)
+    pot_rows = condition_rows(pot_conds)
+
+    grid_X = np.ascontiguousarray(global_grid.X, dtype=np.float64).reshape(-1, num_points, num_comps)
+    grid_GM = np.ascontiguousarray(global_grid.GM, dtype=np.float64).reshape(-1, num_points)
+    grid_phase_ids = np.ascontiguousarray(global_grid.Phase_id).reshape(-1, num_points)
+    grid_Y_offsets = np.ascontiguousarray(global_grid.Y_offsets).reshape(-1, num_points)
+    grid_Y_dof = np.ascontiguousarray(global_grid.Y_dof).reshape(-1, num_points)
+    grid_Y_packed = np.ascontiguousarray(global_grid.Y_packed, dtype=np.float64)
+    total_moles = float(global_grid.coords['N'][0])
+
+    # Flat views of the results; these write through to result_array
+    result_GM = result_array.GM.reshape(num_conds)
+    result_MU = result_array.MU.reshape(num_conds, num_comps)
+    result_NP = result_array.NP.reshape(num_conds, -1)
+    result_points = result_array.points.reshape(num_conds, -1)
+    result_X = result_array.X.reshape(result_NP.shape + (num_comps,))
+    result_Y = result_array.Y.reshape(result_NP.shape + (-1,))
+    result_phase_ids = np.empty(result_NP.shape, dtype=np.int16)
+    result_statistics = np.zeros((num_conds, len(HYPERPLANE_STATISTICS)), dtype=np.int32) if diagnostics else None
+
+    if hull_index is True and len(pot_conds) == 0 and 2 <= num_comps <= LowerHullIndex.max_components:
+        hull_index = LowerHullIndex(global_grid)
+    use_hull_index = isinstance(hull_index, LowerHullIndex) and len(pot_conds) == 0
+    if use_hull_index:
+        # Locate every condition on the precomputed facets of its slice, then solve for the phase amounts
+        if hull_index.grid_shape != global_grid.GM.shape:
+            raise ValueError('Hull index was built from a different grid')
+        target_amounts = np.zeros((num_conds, num_comps))
+        target_amounts[:, comp_conds_indices] = comp_values[comp_rows][:, comp_conds_indices]
+        dependent_comp = sorted(set(range(num_comps)) - set(comp_conds_indices))[0]
+        target_amounts[:, dependent_comp] = total_moles - target_amounts.sum(axis=-1)
+        result_MU[...] = 0
+        result_NP[...] = 0
+        result_points[...] = 0
+        covered = []
+        uncovered = []
+        for row in np.unique(statevar_rows):
+            conds = np.nonzero(statevar_rows == row)[0]
+            if hull_index.potentials[row] is None:
+                uncovered.append(conds)
+                continue
+            facets = hull_index.locate(row, target_amounts[conds] / total_moles)
+            simplices = hull_index.simplices[row][facets]
+            vertex_compositions = grid_X[row][simplices]
+            fractions = np.linalg.solve(np.swapaxes(vertex_compositions, -1, -2), target_amounts[conds])
+            inside = np.all(fractions > -1e-10 * total_moles, axis=-1)
+            uncovered.append(conds[~inside])
+            conds, facets, simplices, fractions = conds[inside], facets[inside], simplices[inside], fractions[inside]
+            covered.append(conds)
+            result_MU[conds] = hull_index.potentials[row][facets]
+            result_NP[conds, :num_comps] = fractions
+            result_points[conds, :num_comps] = simplices
+            result_GM[conds] = np.sum(fractions * grid_GM[row][simplices], axis=-1)
+        hull_copy_out(grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed, statevar_rows,
+                      result_GM, result_NP, result_points, result_X, result_Y, result_phase_ids,
+                      np.concatenate(covered + [np.empty(0, dtype=np.intp)]))
+        uncovered = np.concatenate(uncovered + [np.empty(0, dtype=np.intp)])
+        if len(uncovered) > 0:
+            # Solve the rest with hyperplane(), into temporary arrays
+            subset_results = [np.empty((len(uncovered),) + arr.shape[1:], dtype=arr.dtype)
+                              for arr in (result_GM, result_MU, result_NP, result_points, result_X, result_Y,
+                                          result_phase_ids)]
+            subset_statistics = result_statistics[uncovered] if diagnostics else None
+            hull_conditions(grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed,
+                            statevar_rows[uncovered], comp_values, comp_rows[uncovered],
+                            cart_pot_values, pot_rows[uncovered], pot_conds_indices, comp_conds_indices,
+                            total_moles, *subset_results, np.full(len(uncovered), -1, dtype=np.intp),
+                            0, len(uncovered), subset_statistics)
+            for arr, subset_arr in zip((result_GM, result_MU, result_NP, result_points, result_X, result_Y,
+                                        result_phase_ids), subset_results):
+                arr[uncovered] = subset_arr
+            if diagnostics:
+                result_statistics[uncovered] = subset_statistics
+    elif len(pot_conds) == num_comps - 1:
+        # Fully open system: only one component has no fixed chemical potential, so every simplex
+        # is a single point. The hyperplane through a point x has free potential
+        # (G - sum_fixed MU_i x_i) / x_free, and the lowest such hyperplane is the solution.
+        free_comp = sorted(set(range(num_comps)) - set(pot_conds_indices))[0]
+        pot_values = cart_pot_values[pot_rows]
+        result_MU[...] = 0
+        result_MU[:, pot_conds_indices] = pot_values
+        result_NP[...] = 0
+        result_NP[:, 0] = total_moles
+        result_points[...] = 0
+        # Bound the (conditions, points) temporary to about 2**22 elements
+        chunk_size = max(1, 2**22 // num_points)
+        for row in np.unique(statevar_rows):
+            conds = np.nonzero(statevar_rows == row)[0]
+            row_X = grid_X[row]
+            free_amounts = row_X[:, free_comp]
+            for start in range(0, len(conds), chunk_size):
+                chunk = conds[start:start+chunk_size]
+                transformed_GM = grid_GM[row][np.newaxis, :] - np.dot(pot_values[chunk], row_X[:, pot_conds_indices].T)
+                with np.errstate(divide='ignore', invalid='ignore'):
+                    free_potentials = transformed_GM / free_amounts
+                free_potentials[:, ~(free_amounts > 0)] = np.inf
+                free_potentials[np.isnan(free_potentials)] = np.inf
+                points = np.argmin(free_potentials, axis=-1)
+                result_MU[chunk, free_comp] = free_potentials[np.arange(len(chunk)), points]
+                result_points[chunk, 0] = points
+                result_GM[chunk] = total_moles * grid_GM[row][points]
+        hull_copy_out(grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed, statevar_rows,
+                      result_GM, result_NP, result_points, result_X, result_Y, result_phase_ids,
+                      np.arange(num_conds, dtype=np.intp))
+    else:
+        # Walk each row of the last condition axis, seeding every condition from its predecessor
+        # on the same slice of the grid. Rows are never split between tasks, so the result does
+        # not depend on the executor.
+        row_length = max(conds_shape[-1], 1) if len(conds_shape) > 0 else 1
+        seed_conditions = np.arange(num_conds, dtype=np.intp) - 1
+        seed_conditions[::row_length] = -1
+        seed_conditions[1:][statevar_rows[1:] != statevar_rows[:-1]] = -1
+        if not warm_start:
+            seed_conditions[:] = -1
+        conditions_per_task = row_length * max(1, -(-conditions_per_task // row_length))
+
+        def solve_conditions(start, stop):
+            hull_conditions(grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed,
+                            statevar_rows, comp_values, comp_rows, cart_pot_values, pot_rows,
+                            pot_conds_indices, comp_conds_indices, total_moles,
+                            result_GM, result_MU, result_NP, result_points, result_X, result_Y,
+                            result_phase_ids, seed_conditions, start, stop, result_statistics)
 
-    it = np.nditer(result_array_GM_values, flags=['multi_index'])
-    comp_coord_shape = tuple(len(result_array.coords[cond]) for cond in comp_conds)
-    pot_coord_shape = tuple(len(result_array.coords[cond]) for cond in pot_conds)
-    while not it.finished:
-        indep_idx = []
-        # Relies on being ordered
-        for sv in state_variables:
-            if str(sv) in result_array.coords.keys():
-                coord_idx = list(result_array.coords.keys()).index(str(sv))
-                indep_idx.append(it.multi_index[coord_idx])
-            else:
-                # free state variable
-                indep_idx.append(0)
-        indep_idx = tuple(indep_idx)
-        if len(comp_conds) > 0:
-            comp_idx = np.ravel_multi_index(tuple(idx for idx, key in zip(it.multi_index, result_array_GM_dims) if key in comp_conds), comp_coord_shape)
-            idx_comp_values = comp_values[comp_idx, :]
+        # Conditions are independent and each writes only its own slice of result_array
+        if executor is None:
+            solve_conditions(0, num_conds)
         else:
-            idx_comp_values = np.atleast_1d(1.)
-        if len(pot_conds) > 0:
-            pot_idx = np.ravel_multi_index(tuple(idx for idx, key in zip(it.multi_index, result_array_GM_dims) if key in pot_conds), pot_coord_shape)
-            idx_pot_values = np.array(cart_pot_values[pot_idx, :])
-
-        idx_global_grid_X_values = global_grid_X_values[indep_idx]
-        idx_global_grid_GM_values = global_grid_GM_values[indep_idx]
-        idx_result_array_MU_values = result_array_MU_values[it.multi_index]
-        idx_result_array_MU_values[:] = 0
-        for idx in range(len(pot_conds_indices)):
-            idx_result_array_MU_values[pot_conds_indices[idx]] = idx_pot_values[idx]
-        idx_result_array_NP_values = result_array_NP_values[it.multi_index]
-        idx_result_array_points_values = result_array_points_values[it.multi_index]
-        result_array_GM_values[it.multi_index] = \
-            hyperplane(idx_global_grid_X_values, idx_global_grid_GM_values,
-                       idx_comp_values, idx_result_array_MU_values, float(global_grid.coords['N'][0]),
-                       pot_conds_indices, comp_conds_indices,
-                       idx_result_array_NP_values, idx_result_array_points_values)
-        # Copy phase values out
-        points = result_array_points_values[it.multi_index]
-        result_array_Phase_values[it.multi_index][:num_comps] = global_grid_Phase_values[indep_idx].take(points, axis=0)[:num_comps]
-        result_array_X_values[it.multi_index][:num_comps] = global_grid_X_values[indep_idx].take(points, axis=0)[:num_comps]
-        result_array_Y_values[it.multi_index][:num_comps] = global_grid_Y_values[indep_idx].take(points, axis=0)[:num_comps]
-        # Special case: Sometimes fictitious points slip into the result
-        if '_FAKE_' in result_array_Phase_values[it.multi_index]:
-            new_energy = 0.
-            molesum = 0.
-            for idx in range(len(result_array_Phase_values[it.multi_index])):
-                midx = it.multi_index + (idx,)
-                if result_array_Phase_values[midx] == '_FAKE_':
-                    result_array_Phase_values[midx] = ''
-                    result_array_X_values[midx] = np.nan
-                    result_array_Y_values[midx] = np.nan
-                    idx_result_array_NP_values[idx] = np.nan
-                else:
-                    new_energy += idx_result_array_NP_values[idx] * global_grid.GM[np.index_exp[indep_idx + (points[idx],)]]
-                    molesum += idx_result_array_NP_values[idx]
-            result_array_GM_values[it.multi_index] = new_energy / molesum
-        it.iternext()
+            futures = [executor.submit(solve_conditions, start, min(start + conditions_per_task, num_conds))
+                       for start in range(0, num_conds, conditions_per_task)]
+            for future in futures:
+                future.result()
+    # Code -1 (no phase) picks the trailing empty name
+    phase_names = np.append(np.asarray(global_grid.phase_names), '')
+    result_array.Phase[...] = phase_names[result_phase_ids].reshape(result_array.Phase.shape)
     result_array.remove('points')
+    if diagnostics:
+        for idx, name in enumerate(HYPERPLANE_STATISTICS):
+            result_array.add_variable('hull_' + name, result_array_GM_dims,
+                                      result_statistics[:, idx].reshape(conds_shape))
     return result_array
@@ -2,62 +2,172 @@ cimport cython
 import numpy as np
 cimport numpy as np
 from pycalphad.core.composition_set cimport CompositionSet
+from pycalphad.core.phase_rec cimport PhaseRecord
 from pycalphad.core.constants import MIN_SITE_FRACTION
-from copy import copy
 cimport scipy.linalg.cython_lapack as cython_lapack
 from libc.stdlib cimport malloc, free
 
+cdef double _MIN_SITE_FRACTION = MIN_SITE_FRACTION
+
+# One record per Newton iteration of find_solution, kept for the last trace_length iterations
+CONVERGENCE_TRACE_DTYPE = np.dtype([('iteration', np.int32), ('mass_residual', np.float64),
+                                    ('largest_internal_cons_max_residual', np.float64),
+                                    ('largest_moles_change', np.float64), ('step_size', np.float64),
+                                    ('num_stable_phases', np.int32), ('phase_set_changed', np.bool_)])
+
+# Reciprocal condition number below which the QR solution is discarded in favor of the SVD
+cdef double QR_MIN_RCOND = 1e-10
+
+cdef int lstsq_workspace_query(int M, int N, int* liwork) noexcept nogil:
+    """
+    Return the number of doubles of work space needed by lstsq and lstsq_qr for an M x N system,
+    and write the number of integers needed into liwork.
+    """
+    cdef int NRHS = 1
+    cdef int info = 0
+    cdef int rank = 0
+    cdef int lwork = -1
+    cdef int lwork_out
+    cdef double rcond = -1
+    cdef double work_query = 0
+    cdef int iwork_query = 0
+    cdef double dummy = 0  # A, x and the singular values are not referenced by a workspace query
+    cdef char trans = b'N'
+
+    cython_lapack.dgelsd(&M, &N, &NRHS, &dummy, &M, &dummy, &M, &dummy, &rcond, &rank,
+                         &work_query, &lwork, &iwork_query, &info)
+    lwork_out = <int>work_query
+    cython_lapack.dgels(&trans, &M, &N, &NRHS, &dummy, &M, &dummy, &M, &work_query, &lwork, &info)
+    # dtrcon needs 3*N doubles and N integers to estimate the condition of R
+    liwork[0] = max(iwork_query, N)
+    return max(lwork_out, <int>work_query, 3*N)
+
 @cython.boundscheck(False)
-cdef void lstsq(double *A, int M, int N, double* x, double rcond) nogil:
+cdef void lstsq(double *A, int M, int N, int lda, double* x, double rcond,
+                double* work, int lwork, double* singular_values, int* iwork) noexcept nogil:
+    """
+    Solve the column-major M x N system A x = b in place with an SVD; x holds b on entry and needs max(M, N) entries.
+    work, singular_values (N entries) and iwork are work space sized by lstsq_workspace_query.
+    """
     cdef int i
     cdef int NRHS = 1
-    cdef int iwork = 0
     cdef int info = 0
-    cdef int SMLSIZ = 50  # this is a guess
-    cdef int NLVL = 10  # this is also a guess
-    cdef int lwork = 12*N + 2*N*SMLSIZ + 8*N*NLVL + N*NRHS + (SMLSIZ+1)**2
     cdef int rank = 0
-    cdef double* work = <double*>malloc(lwork * sizeof(double))
-    cdef double* singular_values = <double*>malloc(N * sizeof(double))
 
-    cython_lapack.dgelsd(&M, &N, &NRHS, A, &N, x, &M, singular_values, &rcond, &rank,
-                         work, &lwork, &iwork, &info)
-    free(singular_values)
-    free(work)
+    cython_lapack.dgelsd(&M, &N, &NRHS, A, &lda, x, &M, singular_values, &rcond, &rank,
+                         work, &lwork, iwork, &info)
     if info != 0:
         for i in range(N):
             x[i] = -1e19
 
 @cython.boundscheck(False)
-cdef void invert_matrix(double *A, int N, double *A_inv_out, int* ipiv) nogil:
-    "A_inv_out should be the identity matrix; it will be overwritten."
+cdef void lstsq_qr(double *A, int M, int N, int lda, double* x, double rcond,
+                   double* A_copy, double* x_copy,
+                   double* work, int lwork, double* singular_values, int* iwork) noexcept nogil:
+    """
+    Same as lstsq, but try a QR factorization first and only fall back to the SVD
+    when the system is rank deficient or ill-conditioned.
+    A_copy (lda x N) and x_copy (max(M, N) entries) keep the original system for the fallback.
+    """
+    cdef int i, j
+    cdef int NRHS = 1
     cdef int info = 0
+    cdef double r_rcond = 0
+    cdef char trans = b'N'
+    cdef char norm = b'1'
+    cdef char uplo = b'U'
+    cdef char diag = b'N'
+
+    if M < N:
+        lstsq(A, M, N, lda, x, rcond, work, lwork, singular_values, iwork)
+        return
+    for j in range(N):
+        for i in range(M):
+            A_copy[j*lda + i] = A[j*lda + i]
+    for i in range(M):
+        x_copy[i] = x[i]
+    cython_lapack.dgels(&trans, &M, &N, &NRHS, A, &lda, x, &M, work, &lwork, &info)
+    if info == 0:
+        # A now holds R in its upper triangle
+        cython_lapack.dtrcon(&norm, &uplo, &diag, &N, A, &lda, &r_rcond, work, iwork, &info)
+    if info != 0 or not (r_rcond >= QR_MIN_RCOND):
+        for j in range(N):
+            for i in range(M):
+                A[j*lda + i] = A_copy[j*lda + i]
+        for i in range(M):
+            x[i] = x_copy[i]
+        lstsq(A, M, N, lda, x, rcond, work, lwork, singular_values, iwork)
 
-    cython_lapack.dgesv(&N, &N, A, &N, ipiv, A_inv_out, &N, &info)
-    if info != 0:
-        for i in range(N**2):
-            A_inv_out[i] = -1e19
+@cython.boundscheck(False)
+cdef void lu_solve(double *A, int N, double *B, int NRHS, int* ipiv) noexcept nogil:
+    """
+    Solve A x = b for the NRHS right-hand sides stored as the rows of B (overwritten with the solutions).
+    A is a C-ordered N x N matrix; it is overwritten with its LU factors.
+    If A is singular, each solution is filled the way multiplying by a -1e19 inverse would fill it.
+    """
+    cdef int info = 0
+    cdef int i, k
+    cdef double rhs_sum
+    cdef char trans = b'T'  # LAPACK sees the transpose of a C-ordered matrix
 
-cdef void compute_phase_matrix(double[:,::1] phase_matrix, double[:,::1] hess, CompositionSet compset,
+    cython_lapack.dgetrf(&N, &N, A, &N, ipiv, &info)
+    if info == 0:
+        cython_lapack.dgetrs(&trans, &N, &NRHS, A, &N, ipiv, B, &N, &info)
+    if info != 0:
+        for k in range(NRHS):
+            rhs_sum = 0
+            for i in range(N):
+                rhs_sum += B[k*N + i]
+            for i in range(N):
+                B[k*N + i] = -1e19 * rhs_sum
+
+cdef double _max_abs(double* values, int size) noexcept nogil:
+    "Largest absolute value in values; NaN if any entry is NaN, like np.max(np.abs(values))."
+    cdef int i
+    cdef double result = 0
+    for i in range(size):
+        if values[i] != values[i]:
+            return values[i]
+        result = max(result, abs(values[i]))
+    return result
+
+@cython.cdivision(True)
+cdef double _max_relative_change(double[::1] current, double[::1] previous) noexcept nogil:
+    "Same as np.max(np.abs(current/previous - 1)), including inf and NaN for zero entries of previous."
+    cdef int i
+    cdef double change
+    cdef double result = 0
+    for i in range(current.shape[0]):
+        change = abs(current[i] / previous[i] - 1)
+        if change != change:
+            return change
+        result = max(result, change)
+    return result
+
+cdef void compute_phase_matrix(double[:,::1] phase_matrix, double[:,::1] hess, PhaseRecord prx,
                                int num_statevars, double[::1] chemical_potentials, double[::1] phase_dof,
-                               int[::1] fixed_phase_dof_indices):
-    "Compute the LHS of Eq. 41, Sundman 2015."
+                               int[::1] fixed_phase_dof_indices, double[:, ::1] cons_jac_tmp,
+                               double[:, :, ::1] mass_hess_tmp) noexcept nogil:
+    """
+    Compute the LHS of Eq. 41, Sundman 2015.
+    cons_jac_tmp and mass_hess_tmp are scratch space with shapes (num_internal_cons, num_statevars+phase_dof)
+    and (num_components, num_statevars+phase_dof, num_statevars+phase_dof); they are overwritten.
+    """
     cdef int comp_idx, i, j, cons_idx, fixed_dof_idx
     cdef int num_components = chemical_potentials.shape[0]
-    cdef double[:, ::1] cons_jac_tmp = np.zeros((compset.phase_record.num_internal_cons,
-                                                num_statevars + compset.phase_record.phase_dof))
-    cdef double[:,:, ::1] mass_hess_tmp = np.zeros((num_components,
-                                                    num_statevars + compset.phase_record.phase_dof,
-                                                    num_statevars + compset.phase_record.phase_dof))
-    compset.phase_record.internal_cons_jac(cons_jac_tmp, phase_dof)
-    phase_matrix[:compset.phase_record.phase_dof, :compset.phase_record.phase_dof] = hess[
-                                                                                     num_statevars:,
-                                                                                     num_statevars:]
+    cdef int num_phase_dof = prx.phase_dof
+    cdef int num_internal_cons = prx.num_internal_cons
+    cons_jac_tmp[:, :] = 0
+    mass_hess_tmp[:, :, :] = 0
+    prx.internal_cons_jac(cons_jac_tmp, phase_dof)
+    for i in range(num_phase_dof):
+        for j in range(num_phase_dof):
+            phase_matrix[i, j] = hess[num_statevars+i, num_statevars+j]
     for comp_idx in range(num_components):
-        compset.phase_record.formulamole_hess(mass_hess_tmp[comp_idx, :, :], phase_dof, comp_idx)
+        prx.formulamole_hess(mass_hess_tmp[comp_idx, :, :], phase_dof, comp_idx)
     for comp_idx in range(num_components):
-        for i in range(compset.phase_record.phase_dof):
-            for j in range(i, compset.phase_record.phase_dof):
+        for i in range(num_phase_dof):
+            for j in range(i, num_phase_dof):
                 phase_matrix[i, j] -= chemical_potentials[comp_idx] * mass_hess_tmp[comp_idx,
                                                                                     num_statevars+i,
                                                                                     num_statevars+j]
@@ -66,22 +176,21 @@ cdef void compute_phase_matrix(double[:,::1] phase_matrix, double[:,::1] hess, C
                                                                                         num_statevars+j,
                                                                                         num_statevars+i]
 
-    phase_matrix[compset.phase_record.phase_dof:compset.phase_record.phase_dof+compset.phase_record.num_internal_cons,
-                 :compset.phase_record.phase_dof] = cons_jac_tmp[:, num_statevars:]
-    phase_matrix[:compset.phase_record.phase_dof,
-                 compset.phase_record.phase_dof:compset.phase_record.phase_dof+compset.phase_record.num_internal_cons] \
-        = cons_jac_tmp[:, num_statevars:].T
+    for cons_idx in range(num_internal_cons):
+        for i in range(num_phase_dof):
+            phase_matrix[num_phase_dof + cons_idx, i] = cons_jac_tmp[cons_idx, num_statevars+i]
+            phase_matrix[i, num_phase_dof + cons_idx] = cons_jac_tmp[cons_idx, num_statevars+i]
 
     for cons_idx in range(fixed_phase_dof_indices.shape[0]):
         fixed_dof_idx = fixed_phase_dof_indices[cons_idx]
-        phase_matrix[compset.phase_record.phase_dof + compset.phase_record.num_internal_cons + cons_idx, fixed_dof_idx] = 1
-        phase_matrix[fixed_dof_idx, compset.phase_record.phase_dof + compset.phase_record.num_internal_cons] = 1
+        phase_matrix[num_phase_dof + num_internal_cons + cons_idx, fixed_dof_idx] = 1
+        phase_matrix[fixed_dof_idx, num_phase_dof + num_internal_cons] = 1
 
 
 cdef void write_row_stable_phase(double[:] out_row, double* out_rhs, int[::1] free_chemical_potential_indices,
                                  int[::1] free_stable_compset_indices, int[::1] free_statevar_indices,
                                  int[::1] fixed_chemical_potential_indices, double[::1] chemical_potentials,
-                                 double[:, ::1] masses, double[::1] grad, double energy):
+                                 double[:, ::1] masses, double[::1] grad, double energy) noexcept nogil:
     # 1a. This phase row: free chemical potentials
     cdef int free_variable_column_offset = 0
     cdef int chempot_idx, statevar_idx, i
@@ -109,7 +218,7 @@ cdef void write_row_fixed_mole_fraction(double[:] out_row, double* out_rhs, int
                                         double[:, ::1] mass_jac, double[:, ::1] c_component,
                                         double[:, ::1] c_statevars, double[::1] c_G, double[:, ::1] masses,
                                         double moles_normalization, double[::1] moles_normalization_grad,
-                                        double[::1] phase_amt, int idx):
+                                        double[::1] phase_amt, int idx) noexcept nogil:
     cdef int free_variable_column_offset = 0
     cdef int num_statevars = c_statevars.shape[1]
     cdef int chempot_idx, compset_idx, statevar_idx, i, j
@@ -164,7 +273,7 @@ cdef void write_row_fixed_mole_amount(double[:] out_row, double* out_rhs, int co
                                       double[::1] chemical_potentials,
                                       double[:, ::1] mass_jac, double[:, ::1] c_component,
                                       double[:, ::1] c_statevars, double[::1] c_G, double[:, ::1] masses,
-                                      double[::1] phase_amt, int idx):
+                                      double[::1] phase_amt, int idx) noexcept nogil:
     cdef int free_variable_column_offset = 0
     cdef int num_statevars = c_statevars.shape[1]
     cdef int i, j, chempot_idx, compset_idx, statevar_idx
@@ -200,97 +309,173 @@ cdef void write_row_fixed_mole_amount(double[:] out_row, double* out_rhs, int co
                 chempot_idx] * mass_jac[component_idx, num_statevars+j] * c_component[chempot_idx, j]
 
 
-cdef void fill_equilibrium_system(double[::1,:] equilibrium_matrix, double[::1] equilibrium_rhs,
-                                  SystemSpecification spec, SystemState state):
-    cdef int stable_idx, idx, component_row_offset, component_idx, fixed_idx, free_idx
-    cdef int fixed_component_idx, comp_idx, system_amount_index, sv_idx
-    cdef CompositionSet compset
-    cdef CompsetState csst
+cdef void write_phase_row(double[::1,:] equilibrium_matrix, double[::1] equilibrium_rhs, int row,
+                          SystemSpecification spec, SystemState state, CompsetState csst) noexcept nogil:
+    write_row_stable_phase(equilibrium_matrix[row, :], &equilibrium_rhs[row], spec.free_chemical_potential_indices,
+                           state.free_stable_compset_indices, spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
+                           state.chemical_potentials, csst.masses, csst.grad, csst.energy)
+
+
+cdef void add_component_rows(double[::1,:] equilibrium_matrix, double[::1] equilibrium_rhs,
+                             SystemSpecification spec, SystemState state, CompsetState csst, int idx) noexcept nogil:
+    cdef int component_idx, fixed_component_idx
     cdef int num_components = state.chemical_potentials.shape[0]
+    cdef int num_fixed_components = spec.prescribed_elemental_amounts.shape[0]
+    cdef int component_row_offset = state.free_stable_compset_indices.shape[0] + spec.fixed_stable_compset_indices.shape[0]
+    cdef int system_amount_index = component_row_offset + num_fixed_components
+    # 2. Contribute to the row of all fixed components (fixed mole fraction)
+    for fixed_component_idx in range(num_fixed_components):
+        component_idx = spec.prescribed_element_indices[fixed_component_idx]
+        write_row_fixed_mole_fraction(equilibrium_matrix[component_row_offset + fixed_component_idx, :],
+                                      &equilibrium_rhs[component_row_offset + fixed_component_idx],
+                                      component_idx, spec.free_chemical_potential_indices,
+                                      state.free_stable_compset_indices,
+                                      spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
+                                      state.chemical_potentials,
+                                      state.mole_fractions, state.system_amount, csst.mass_jac,
+                                      csst.c_component, csst.c_statevars,
+                                      csst.c_G, csst.masses, csst.moles_normalization,
+                                      csst.moles_normalization_grad, state.phase_amt, idx)
+
+    # 2X. Also handle the N=1 row
+    for component_idx in range(num_components):
+        write_row_fixed_mole_amount(equilibrium_matrix[system_amount_index, :],
+                                    &equilibrium_rhs[system_amount_index], component_idx,
+                                    spec.free_chemical_potential_indices, state.free_stable_compset_indices,
+                                    spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
+                                    state.chemical_potentials, csst.mass_jac, csst.c_component,
+                                    csst.c_statevars, csst.c_G, csst.masses,
+                                    state.phase_amt, idx)
+
+
+cdef void project_phase_corrections(SystemSpecification spec, SystemState state, CompsetState csst) noexcept nogil:
+    """
+    Project the corrections of this composition set onto the mass gradient of each prescribed component
+    (row r of row_projections for prescribed component r) and onto the gradient of its total moles (last row).
+    Columns are the free chemical potentials, the free state variables, and c_G shifted by the fixed chemical potentials.
+    Every component row of the equilibrium matrix is a combination of two of these rows.
+    """
+    cdef int num_statevars = spec.num_statevars
+    cdef int num_free_chempots = spec.free_chemical_potential_indices.shape[0]
+    cdef int num_free_statevars = spec.free_statevar_indices.shape[0]
+    cdef int num_fixed_components = spec.prescribed_elemental_amounts.shape[0]
+    cdef int rhs_column = num_free_chempots + num_free_statevars
+    cdef int num_phase_dof = csst.c_G.shape[0]
+    cdef double[:, ::1] projections = csst.row_projections
+    cdef double[::1] shifted_c_G = csst.shifted_c_G
+    cdef int row, col, i, j, chempot_idx
+    cdef double weight
+
+    for j in range(num_phase_dof):
+        shifted_c_G[j] = csst.c_G[j]
+        for i in range(spec.fixed_chemical_potential_indices.shape[0]):
+            chempot_idx = spec.fixed_chemical_potential_indices[i]
+            shifted_c_G[j] += state.chemical_potentials[chempot_idx] * csst.c_component[chempot_idx, j]
+    for row in range(num_fixed_components + 1):
+        for col in range(rhs_column + 1):
+            projections[row, col] = 0
+        for j in range(num_phase_dof):
+            if row < num_fixed_components:
+                weight = csst.mass_jac[spec.prescribed_element_indices[row], num_statevars + j]
+            else:
+                weight = csst.moles_normalization_grad[num_statevars + j]
+            for i in range(num_free_chempots):
+                projections[row, i] += weight * csst.c_component[spec.free_chemical_potential_indices[i], j]
+            for i in range(num_free_statevars):
+                projections[row, num_free_chempots + i] += weight * csst.c_statevars[j, spec.free_statevar_indices[i]]
+            projections[row, rhs_column] += weight * shifted_c_G[j]
+
+
+cdef void add_component_rows_block(double[::1,:] equilibrium_matrix, double[::1] equilibrium_rhs,
+                                   SystemSpecification spec, SystemState state, CompsetState csst, int idx,
+                                   int phase_amt_column) noexcept nogil:
+    """
+    Same contribution as add_component_rows, built from the projections of project_phase_corrections.
+    phase_amt_column is the column of this composition set's amount, or -1 if its amount is fixed.
+    """
+    cdef int num_free_chempots = spec.free_chemical_potential_indices.shape[0]
+    cdef int num_free_statevars = spec.free_statevar_indices.shape[0]
+    cdef int num_fixed_components = spec.prescribed_elemental_amounts.shape[0]
+    cdef int component_row_offset = state.free_stable_compset_indices.shape[0] + spec.fixed_stable_compset_indices.shape[0]
+    cdef int system_amount_index = component_row_offset + num_fixed_components
+    cdef int statevar_column_offset = num_free_chempots + state.free_stable_compset_indices.shape[0]
+    cdef int rhs_column = num_free_chempots + num_free_statevars
+    cdef double[:, ::1] projections = csst.row_projections
+    cdef double phase_amt = state.phase_amt[idx]
+    cdef double system_amount = state.system_amount
+    cdef double mole_fraction
+    cdef int fixed_component_idx, component_idx, row, i
+
+    project_phase_corrections(spec, state, csst)
+    # 2. Rows of the fixed components (fixed mole fraction)
+    for fixed_component_idx in range(num_fixed_components):
+        component_idx = spec.prescribed_element_indices[fixed_component_idx]
+        mole_fraction = state.mole_fractions[component_idx]
+        row = component_row_offset + fixed_component_idx
+        for i in range(num_free_chempots):
+            equilibrium_matrix[row, i] += (phase_amt/system_amount) * \
+                (projections[fixed_component_idx, i] - mole_fraction * projections[num_fixed_components, i])
+        if phase_amt_column >= 0:
+            equilibrium_matrix[row, phase_amt_column] = \
+                (1./system_amount) * (csst.masses[component_idx, 0] - mole_fraction * csst.moles_normalization)
+        for i in range(num_free_statevars):
+            equilibrium_matrix[row, statevar_column_offset + i] += (phase_amt/system_amount) * \
+                (projections[fixed_component_idx, num_free_chempots + i] -
+                 mole_fraction * projections[num_fixed_components, num_free_chempots + i])
+        equilibrium_rhs[row] -= (phase_amt/system_amount) * \
+            (projections[fixed_component_idx, rhs_column] - mole_fraction * projections[num_fixed_components, rhs_column])
+    # 2X. The N=1 row
+    for i in range(num_free_chempots):
+        equilibrium_matrix[system_amount_index, i] += phase_amt * projections[num_fixed_components, i]
+    if phase_amt_column >= 0:
+        equilibrium_matrix[system_amount_index, phase_amt_column] += csst.moles_normalization
+    for i in range(num_free_statevars):
+        equilibrium_matrix[system_amount_index, statevar_column_offset + i] += \
+            phase_amt * projections[num_fixed_components, num_free_chempots + i]
+    equilibrium_rhs[system_amount_index] -= phase_amt * projections[num_fixed_components, rhs_column]
+
+
+cdef void fill_equilibrium_system(double[::1,:] equilibrium_matrix, double[::1] equilibrium_rhs,
+                                  SystemSpecification spec, SystemState state) noexcept nogil:
+    cdef int stable_idx, idx, component_row_offset, component_idx, fixed_idx
+    cdef int fixed_component_idx, system_amount_index
+    cdef double component_residual, system_residual
     cdef int num_stable_phases = state.free_stable_compset_indices.shape[0]
     cdef int num_fixed_phases = spec.fixed_stable_compset_indices.shape[0]
     cdef int num_fixed_components = spec.prescribed_elemental_amounts.shape[0]
 
-    for stable_idx in range(state.free_stable_compset_indices.shape[0]):
+    for stable_idx in range(num_stable_phases):
         idx = state.free_stable_compset_indices[stable_idx]
-        compset = state.compsets[idx]
-        csst = state.cs_states[idx]
-
-        write_row_stable_phase(equilibrium_matrix[stable_idx, :], &equilibrium_rhs[stable_idx], spec.free_chemical_potential_indices,
-                               state.free_stable_compset_indices, spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                               state.chemical_potentials, csst.masses, csst.grad, csst.energy)
+        write_phase_row(equilibrium_matrix, equilibrium_rhs, stable_idx, spec, state,
+                        <CompsetState>state.compset_states[idx])
 
     # Handle phases which are fixed to be stable at some amount
     # Example shown in Eq. 60, Sundman et al 2015
-    for fixed_idx in range(spec.fixed_stable_compset_indices.shape[0]):
+    for fixed_idx in range(num_fixed_phases):
         idx = spec.fixed_stable_compset_indices[fixed_idx]
-        compset = state.compsets[idx]
-        csst = state.cs_states[idx]
-        write_row_stable_phase(equilibrium_matrix[num_stable_phases + fixed_idx, :],
-                               &equilibrium_rhs[num_stable_phases + fixed_idx], spec.free_chemical_potential_indices,
-                               state.free_stable_compset_indices, spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                               state.chemical_potentials, csst.masses, csst.grad, csst.energy)
-
-    for stable_idx in range(state.free_stable_compset_indices.shape[0]):
+        write_phase_row(equilibrium_matrix, equilibrium_rhs, num_stable_phases + fixed_idx, spec, state,
+                        <CompsetState>state.compset_states[idx])
+
+    # Component rows only depend on a phase through a few projections of its corrections,
+    # and only the phase's own amount column is nonzero in the phase amount block
+    for stable_idx in range(num_stable_phases):
         idx = state.free_stable_compset_indices[stable_idx]
-        compset = state.compsets[idx]
-        csst = state.cs_states[idx]
-        # 2. Contribute to the row of all fixed components (fixed mole fraction)
-        component_row_offset = num_stable_phases + num_fixed_phases
-        for fixed_component_idx in range(num_fixed_components):
-            component_idx = spec.prescribed_element_indices[fixed_component_idx]
-            write_row_fixed_mole_fraction(equilibrium_matrix[component_row_offset + fixed_component_idx, :],
-                                          &equilibrium_rhs[component_row_offset + fixed_component_idx],
-                                          component_idx, spec.free_chemical_potential_indices,
-                                          state.free_stable_compset_indices,
-                                          spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                                          state.chemical_potentials,
-                                          state.mole_fractions, state.system_amount, csst.mass_jac,
-                                          csst.c_component, csst.c_statevars,
-                                          csst.c_G, csst.masses, csst.moles_normalization,
-                                          csst.moles_normalization_grad, state.phase_amt, idx)
-
-        system_amount_index = component_row_offset + num_fixed_components
-        # 2X. Also handle the N=1 row
-        for component_idx in range(num_components):
-            write_row_fixed_mole_amount(equilibrium_matrix[system_amount_index, :],
-                                        &equilibrium_rhs[system_amount_index], component_idx,
-                                        spec.free_chemical_potential_indices, state.free_stable_compset_indices,
-                                        spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                                        state.chemical_potentials, csst.mass_jac, csst.c_component,
-                                        csst.c_statevars, csst.c_G, csst.masses,
-                                        state.phase_amt, idx)
-
-    for fixed_idx in range(spec.fixed_stable_compset_indices.shape[0]):
-        idx = spec.fixed_stable_compset_indices[fixed_idx]
-        compset = state.compsets[idx]
-        csst = state.cs_states[idx]
-        # 2. Contribute to the row of all fixed components (fixed mole fraction)
-        component_row_offset = num_stable_phases + num_fixed_phases
-        for fixed_component_idx in range(num_fixed_components):
-            component_idx = spec.prescribed_element_indices[fixed_component_idx]
-            write_row_fixed_mole_fraction(equilibrium_matrix[component_row_offset + fixed_component_idx, :],
-                                          &equilibrium_rhs[component_row_offset + fixed_component_idx],
-                                          component_idx, spec.free_chemical_potential_indices,
-                                          state.free_stable_compset_indices,
-                                          spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                                          state.chemical_potentials,
-                                          state.mole_fractions, state.system_amount, csst.mass_jac,
-                                          csst.c_component, csst.c_statevars,
-                                          csst.c_G, csst.masses, csst.moles_normalization,
-                                          csst.moles_normalization_grad, state.phase_amt, idx)
-
-        system_amount_index = component_row_offset + num_fixed_components
-        # 2X. Also handle the N=1 row
-        for component_idx in range(num_components):
-            write_row_fixed_mole_amount(equilibrium_matrix[system_amount_index, :],
-                                        &equilibrium_rhs[system_amount_index], component_idx,
-                                        spec.free_chemical_potential_indices, state.free_stable_compset_indices,
-                                        spec.free_statevar_indices, spec.fixed_chemical_potential_indices,
-                                        state.chemical_potentials, csst.mass_jac, csst.c_component,
-                                        csst.c_statevars, csst.c_G, csst.masses,
-                                        state.phase_amt, idx)
+        if state.dense_assembly:
+            add_component_rows(equilibrium_matrix, equilibrium_rhs, spec, state,
+                               <CompsetState>state.compset_states[idx], idx)
+        else:
+            add_component_rows_block(equilibrium_matrix, equilibrium_rhs, spec, state,
+                                     <CompsetState>state.compset_states[idx], idx,
+                                     spec.free_chemical_potential_indices.shape[0] + stable_idx)
 
+    for fixed_idx in range(num_fixed_phases):
+        idx = spec.fixed_stable_compset_indices[fixed_idx]
+        if state.dense_assembly:
+            add_component_rows(equilibrium_matrix, equilibrium_rhs, spec, state,
+                               <CompsetState>state.compset_states[idx], idx)
+        else:
+            add_component_rows_block(equilibrium_matrix, equilibrium_rhs, spec, state,
+                                     <CompsetState>state.compset_states[idx], idx, -1)
 
     # Add mass residual to fixed component row RHS, plus N=1 row
     component_row_offset = num_stable_phases + num_fixed_phases
@@ -306,7 +491,8 @@ cdef void fill_equilibrium_system(double[::1,:] equilibrium_matrix, double[::1]
 cdef void extract_equilibrium_solution(double[::1] chemical_potentials, double[::1] phase_amt, double[::1] delta_statevars,
                                  int[::1] free_chemical_potential_indices, int[::1] free_statevar_indices,
                                  int[::1] free_stable_compset_indices, double[::1] equilibrium_soln,
-                                 double[:] largest_statevar_change, double[:] largest_phase_amt_change, list dof):
+                                 double* largest_statevar_change, double* largest_phase_amt_change,
+                                 double[::1] reference_dof) noexcept nogil:
     cdef int i, idx, chempot_idx, compset_idx, statevar_idx
     cdef int num_statevars = delta_statevars.shape[0]
     cdef int soln_index_offset = 0
@@ -316,10 +502,9 @@ cdef void extract_equilibrium_solution(double[::1] chemical_potentials, double[:
         chempot_change = equilibrium_soln[soln_index_offset + i] - chemical_potentials[chempot_idx]
         chemical_potentials[chempot_idx] = equilibrium_soln[soln_index_offset + i]
     soln_index_offset += free_chemical_potential_indices.shape[0]
-    largest_delta_phase_amt = np.max(np.abs(equilibrium_soln[soln_index_offset:soln_index_offset+free_stable_compset_indices.shape[0]]))
     for i in range(free_stable_compset_indices.shape[0]):
         compset_idx = free_stable_compset_indices[i]
-        phase_amt_change = float(phase_amt[compset_idx])
+        phase_amt_change = phase_amt[compset_idx]
         phase_amt[compset_idx] += equilibrium_soln[soln_index_offset + i]
         phase_amt_change = phase_amt[compset_idx] - phase_amt_change
         largest_phase_amt_change[0] = max(largest_phase_amt_change[0], phase_amt_change)
@@ -330,7 +515,7 @@ cdef void extract_equilibrium_solution(double[::1] chemical_potentials, double[:
         statevar_idx = free_statevar_indices[i]
         delta_statevars[statevar_idx] = equilibrium_soln[soln_index_offset + i]
     for i in range(delta_statevars.shape[0]):
-        psc = abs(delta_statevars[i] / dof[0][i])
+        psc = abs(delta_statevars[i] / reference_dof[i])
         largest_statevar_change[0] = max(largest_statevar_change[0], psc)
 
 
@@ -400,7 +585,6 @@ cdef class CompsetState:
     cdef double[:,::1] mass_jac
     cdef double[:,::1] phase_matrix
     cdef double[::1] phase_rhs
-    cdef double[:,::1] full_e_matrix
     cdef double[::1] c_G
     cdef double[:, ::1] c_statevars
     cdef double[:, ::1] c_component
@@ -409,6 +593,17 @@ cdef class CompsetState:
     cdef double[::1] moles_normalization_grad
     cdef int[::1] fixed_phase_dof_indices
     cdef int[::1] ipiv
+    # Scratch space for recompute and take_step, sized once from the phase shape
+    cdef double[::1] energy_out
+    cdef double[:, ::1] cons_jac_tmp
+    cdef double[:, :, ::1] mass_hess_tmp
+    cdef double[::1] delta_y
+    cdef double[::1] new_y
+    # Right-hand sides of the phase matrix solves for c_G, c_statevars and c_component, one per row
+    cdef double[:, ::1] correction_rhs
+    # Block assembly of the equilibrium matrix: see project_phase_corrections
+    cdef double[:, ::1] row_projections
+    cdef double[::1] shifted_c_G
     def __init__(self, SystemSpecification spec, CompositionSet compset):
         self.x = np.zeros(spec.num_statevars + compset.phase_record.phase_dof)
         self.energy = 0
@@ -421,8 +616,6 @@ cdef class CompsetState:
         self.phase_matrix = np.zeros((compset.phase_record.phase_dof + compset.phase_record.num_internal_cons,
                                       compset.phase_record.phase_dof + compset.phase_record.num_internal_cons))
         self.phase_rhs = np.zeros(compset.phase_record.phase_dof + compset.phase_record.num_internal_cons)
-        self.full_e_matrix = np.zeros((compset.phase_record.phase_dof + compset.phase_record.num_internal_cons,
-                                       compset.phase_record.phase_dof + compset.phase_record.num_internal_cons))
         self.c_G = np.zeros(compset.phase_record.phase_dof)
         self.c_statevars = np.zeros((compset.phase_record.phase_dof, spec.num_statevars))
         self.c_component = np.zeros((spec.num_components, compset.phase_record.phase_dof))
@@ -431,17 +624,33 @@ cdef class CompsetState:
         self.moles_normalization_grad = np.zeros(spec.num_statevars+compset.phase_record.phase_dof)
         self.fixed_phase_dof_indices = np.array([], dtype=np.int32)
         self.ipiv = np.empty(self.phase_matrix.shape[0], dtype=np.int32)
+        self._allocate_workspace()
+
+    cdef void _allocate_workspace(self):
+        cdef int num_statevars = self.c_statevars.shape[1]
+        cdef int phase_dof = self.c_G.shape[0]
+        cdef int num_components = self.masses.shape[0]
+        self.energy_out = np.zeros(1)
+        self.cons_jac_tmp = np.zeros((self.internal_cons.shape[0], num_statevars + phase_dof))
+        self.mass_hess_tmp = np.zeros((num_components, num_statevars + phase_dof, num_statevars + phase_dof))
+        self.delta_y = np.zeros(phase_dof)
+        self.new_y = np.zeros(num_statevars + phase_dof)
+        self.correction_rhs = np.zeros((1 + num_statevars + num_components, self.phase_matrix.shape[0]))
+        self.row_projections = np.zeros((num_components + 1, num_components + num_statevars + 1))
+        self.shifted_c_G = np.zeros(phase_dof)
+
     def __getstate__(self):
         return (np.array(self.x), self.energy, np.array(self.grad), np.array(self.hess),
-                np.array(self.phase_matrix), np.array(self.phase_rhs), np.array(self.full_e_matrix),
+                np.array(self.phase_matrix), np.array(self.phase_rhs),
                 np.array(self.masses), np.array(self.mass_jac), np.array(self.c_G), np.array(self.c_statevars),
                 np.array(self.c_component), self.moles_normalization, np.array(self.internal_cons), np.array(self.moles_normalization_grad),
                 np.array(self.fixed_phase_dof_indices, dtype=np.int32), np.array(self.ipiv, dtype=np.int32))
     def __setstate__(self, state):
-        (self.x, self.energy, self.grad, self.hess, self.phase_matrix, self.phase_rhs, self.full_e_matrix,
+        (self.x, self.energy, self.grad, self.hess, self.phase_matrix, self.phase_rhs,
          self.masses, self.mass_jac, self.c_G, self.c_statevars,
          self.c_component, self.moles_normalization, self.internal_cons, self.moles_normalization_grad, self.fixed_phase_dof_indices,
          self.ipiv) = state
+        self._allocate_workspace()
 
 
 cdef class SystemState:
@@ -450,21 +659,47 @@ cdef class SystemState:
     cdef object dof
     cdef int iteration, num_statevars
     cdef double mass_residual, largest_internal_cons_max_residual, largest_internal_dof_change
+    cdef double largest_moles_change, step_size
     cdef double[::1] phase_amt, chemical_potentials, chempot_diff, delta_statevars
     cdef double[:, ::1] phase_compositions, delta_ms
     cdef double[1] largest_statevar_change, largest_phase_amt_change
     cdef int[::1] free_stable_compset_indices
     cdef double system_amount
     cdef double[::1] mole_fractions
+    # Scratch space for take_step, sized once for the largest system this phase set can produce
+    cdef double[::1,:] equilibrium_matrix  # Fortran ordering required by call into lapack
+    cdef double[::1] equilibrium_soln, previous_chemical_potentials, statevar_step
+    # LAPACK work space for solving the equilibrium system, queried once for max_system_size
+    cdef double[::1] lstsq_work, lstsq_singular_values
+    cdef int[::1] lstsq_iwork
+    # Copy of the equilibrium system, used when the QR solution is rejected
+    cdef double[::1,:] equilibrium_matrix_copy
+    cdef double[::1] equilibrium_soln_copy
+    # Try a QR factorization before the SVD when solving the equilibrium system
+    cdef bint use_qr
+    # Assemble the component rows of the equilibrium matrix one at a time instead of by blocks
+    cdef bint dense_assembly
+    # Backtrack the internal degree of freedom step on a mass balance merit function
+    cdef bint line_search
+    cdef double[::1] merit_amounts
+    # Borrowed references into compsets and cs_states, so the Newton loop can run without the GIL
+    cdef int num_compsets
+    cdef void** phase_records
+    cdef void** compset_states
+    # free_stable_compset_indices is always a view of the leading part of this buffer
+    cdef int[::1] free_stable_buffer
     def __init__(self, SystemSpecification spec, list compsets):
         cdef CompositionSet compset
         self.compsets = compsets
         self.cs_states = [CompsetState(spec, compset) for compset in compsets]
         self.dof = [np.array(compset.dof) for compset in compsets]
+        self.num_statevars = spec.num_statevars
         self.iteration = 0
         self.mass_residual = 1e10
         self.largest_internal_cons_max_residual = 0
         self.largest_internal_dof_change = 0
+        self.largest_moles_change = 0
+        self.step_size = 0
         # Phase fractions need to be converted to moles of formula
         self.phase_amt = np.array([compset.NP for compset in compsets])
         self.chemical_potentials = np.zeros(spec.num_components)
@@ -490,6 +725,46 @@ cdef class SystemState:
                 masses_tmp[:,:] = 0
             # Convert phase fractions to formula units
             self.phase_amt[idx] /= np.sum(self.phase_compositions[idx])
+        self._allocate_workspace()
+
+    def __dealloc__(self):
+        free(self.phase_records)
+        free(self.compset_states)
+
+    cdef void _allocate_workspace(self):
+        cdef CompositionSet compset
+        cdef CompsetState csst
+        cdef int idx, lwork, liwork
+        cdef int num_components = self.chemical_potentials.shape[0]
+        # Rows are free stable phases, fixed phases, prescribed components and the N=1 row.
+        # take_step requires a square system, so this also bounds the number of free variables.
+        cdef int max_system_size = len(self.compsets) + num_components + self.num_statevars + 1
+        # Share memory between the per-phase dof views and self.dof, so the Newton loop can use typed views
+        self.num_compsets = len(self.compsets)
+        free(self.phase_records)
+        free(self.compset_states)
+        self.phase_records = <void**>malloc(self.num_compsets * sizeof(void*))
+        self.compset_states = <void**>malloc(self.num_compsets * sizeof(void*))
+        for idx in range(self.num_compsets):
+            compset = self.compsets[idx]
+            csst = self.cs_states[idx]
+            csst.x = self.dof[idx]
+            self.phase_records[idx] = <void*>compset.phase_record
+            self.compset_states[idx] = <void*>csst
+        self.free_stable_buffer = np.zeros(self.num_compsets, dtype=np.int32)
+        self.set_free_stable_compset_indices(self.free_stable_compset_indices)
+        self.equilibrium_matrix = np.zeros((max_system_size, max_system_size), order='F')
+        self.equilibrium_soln = np.zeros(max_system_size)
+        lwork = lstsq_workspace_query(max_system_size, max_system_size, &liwork)
+        self.lstsq_work = np.zeros(lwork)
+        self.lstsq_singular_values = np.zeros(max_system_size)
+        self.lstsq_iwork = np.zeros(liwork, dtype=np.int32)
+        self.equilibrium_matrix_copy = np.zeros((max_system_size, max_system_size), order='F')
+        self.equilibrium_soln_copy = np.zeros(max_system_size)
+        self.previous_chemical_potentials = np.zeros(num_components)
+        self.statevar_step = np.zeros(self.num_statevars)
+        self.merit_amounts = np.zeros(num_components)
+
     def __getstate__(self):
         return (self.compsets, self.cs_states, self.dof, self.iteration, self.mass_residual, self.largest_internal_cons_max_residual,
                 self.largest_internal_dof_change, np.array(self.phase_amt), np.array(self.chemical_potentials),
@@ -501,28 +776,109 @@ cdef class SystemState:
          self.largest_internal_dof_change, self.phase_amt, self.chemical_potentials,
          self.chempot_diff, self.delta_ms, self.phase_compositions, self.largest_statevar_change[0],
          self.largest_phase_amt_change[0], self.free_stable_compset_indices, self.system_amount, self.mole_fractions) = state
-
-    cdef void recompute(self, SystemSpecification spec):
+        self.num_statevars = self.dof[0].shape[0] - self.compsets[0].phase_record.phase_dof
+        self._allocate_workspace()
+
+    cdef void solve_equilibrium_system(self, int num_equations, int num_free_variables) noexcept nogil:
+        "Solve the system in the leading part of equilibrium_matrix and equilibrium_soln in place."
+        cdef int lda = self.equilibrium_matrix.shape[0]
+        if self.use_qr:
+            lstsq_qr(&self.equilibrium_matrix[0,0], num_equations, num_free_variables, lda,
+                     &self.equilibrium_soln[0], -1,
+                     &self.equilibrium_matrix_copy[0,0], &self.equilibrium_soln_copy[0],
+                     &self.lstsq_work[0], self.lstsq_work.shape[0], &self.lstsq_singular_values[0],
+                     &self.lstsq_iwork[0])
+        else:
+            lstsq(&self.equilibrium_matrix[0,0], num_equations, num_free_variables, lda,
+                  &self.equilibrium_soln[0], -1,
+                  &self.lstsq_work[0], self.lstsq_work.shape[0], &self.lstsq_singular_values[0],
+                  &self.lstsq_iwork[0])
+
+    cdef void set_free_stable_compset_indices(self, int[::1] indices) noexcept nogil:
+        "Copy indices, which may alias the current indices, into the free stable phase buffer."
+        cdef int i
+        for i in range(indices.shape[0]):
+            self.free_stable_buffer[i] = indices[i]
+        self.free_stable_compset_indices = self.free_stable_buffer[:indices.shape[0]]
+
+    cdef void copy_from(self, SystemState other) noexcept nogil:
+        "Overwrite the per-iteration quantities of this state with those of other, which must share its phase set."
+        cdef int i, j
+        self.iteration = other.iteration
+        self.mass_residual = other.mass_residual
+        self.largest_internal_cons_max_residual = other.largest_internal_cons_max_residual
+        self.largest_internal_dof_change = other.largest_internal_dof_change
+        self.largest_moles_change = other.largest_moles_change
+        self.step_size = other.step_size
+        self.largest_statevar_change[0] = other.largest_statevar_change[0]
+        self.largest_phase_amt_change[0] = other.largest_phase_amt_change[0]
+        self.system_amount = other.system_amount
+        self.set_free_stable_compset_indices(other.free_stable_compset_indices)
+        for i in range(self.phase_amt.shape[0]):
+            self.phase_amt[i] = other.phase_amt[i]
+            for j in range(self.phase_compositions.shape[1]):
+                self.phase_compositions[i, j] = other.phase_compositions[i, j]
+                self.delta_ms[i, j] = other.delta_ms[i, j]
+        for j in range(self.chemical_potentials.shape[0]):
+            self.chemical_potentials[j] = other.chemical_potentials[j]
+            self.chempot_diff[j] = other.chempot_diff[j]
+            self.mole_fractions[j] = other.mole_fractions[j]
+        for j in range(self.delta_statevars.shape[0]):
+            self.delta_statevars[j] = other.delta_statevars[j]
+
+    cdef void copy_dof_from(self, SystemState other) noexcept nogil:
+        "Overwrite the degrees of freedom of every composition set with those of other."
+        cdef double[::1] x, other_x
+        cdef int idx, i
+        for idx in range(self.num_compsets):
+            x = (<CompsetState>self.compset_states[idx]).x
+            other_x = (<CompsetState>other.compset_states[idx]).x
+            for i in range(x.shape[0]):
+                x[i] = other_x[i]
+
+    @cython.cdivision(True)
+    cdef double mass_balance_merit(self, SystemSpecification spec) noexcept nogil:
+        """
+        Residual of the prescribed mole fractions and system amount at the current degrees of freedom and phase amounts.
+        Only scratch space is written, so mass_residual and phase_compositions still describe the last recompute.
+        """
+        cdef int idx, comp_idx, fixed_component_idx
+        cdef double system_amount = 0
+        cdef double merit
+        for comp_idx in range(spec.num_components):
+            self.merit_amounts[comp_idx] = 0
+        for idx in range(self.num_compsets):
+            if self.phase_amt[idx] > 0:
+                system_amount += self._add_compset_amounts(<CompsetState>self.compset_states[idx],
+                                                           <PhaseRecord>self.phase_records[idx], idx,
+                                                           spec.num_components)
+        merit = abs(system_amount - spec.prescribed_system_amount)
+        for fixed_component_idx in range(spec.prescribed_elemental_amounts.shape[0]):
+            comp_idx = spec.prescribed_element_indices[fixed_component_idx]
+            merit += abs(self.merit_amounts[comp_idx] / system_amount - spec.prescribed_elemental_amounts[fixed_component_idx])
+        return merit
+
+    cdef double _add_compset_amounts(self, CompsetState csst, PhaseRecord prx, int idx, int num_components) noexcept nogil:
+        "Add the moles of each component in this composition set to merit_amounts, and return its total moles."
+        cdef int comp_idx
+        cdef double total = 0
+        for comp_idx in range(num_components):
+            csst.masses[comp_idx, 0] = 0
+            prx.formulamole_obj(csst.masses[comp_idx, :], csst.x, comp_idx)
+            self.merit_amounts[comp_idx] += self.phase_amt[idx] * csst.masses[comp_idx, 0]
+            total += self.phase_amt[idx] * csst.masses[comp_idx, 0]
+        return total
+
+    cdef void recompute(self, SystemSpecification spec) noexcept nogil:
         cdef int num_components = spec.num_components
-        cdef CompositionSet compset
-        cdef CompsetState csst
-        cdef double[::1] x
-        cdef int idx, comp_idx, cons_idx, i, j, stable_idx, fixed_idx, component_idx, fixed_component_idx
+        cdef int idx, comp_idx, component_idx, fixed_component_idx
         self.mole_fractions[:] = 0
         self.delta_ms[:, :] = 0
         self.system_amount = 0
         # Compute normalized global quantities
-        for idx in range(len(self.compsets)):
-            x = self.dof[idx]
-            compset = self.compsets[idx]
-            csst = self.cs_states[idx]
-            csst.masses[:,:] = 0
-            for comp_idx in range(num_components):
-                compset.phase_record.formulamole_obj(csst.masses[comp_idx, :], x, comp_idx)
-                if self.phase_amt[idx] > 0:
-                    self.mole_fractions[comp_idx] += self.phase_amt[idx] * csst.masses[comp_idx, 0]
-                    self.system_amount += self.phase_amt[idx] * csst.masses[comp_idx, 0]
-                self.phase_compositions[idx, comp_idx] = csst.masses[comp_idx, 0]
+        for idx in range(self.num_compsets):
+            self._compute_compset_masses(<CompsetState>self.compset_states[idx],
+                                         <PhaseRecord>self.phase_records[idx], idx, num_components)
         for comp_idx in range(self.mole_fractions.shape[0]):
             self.mole_fractions[comp_idx] /= self.system_amount
 
@@ -531,89 +887,160 @@ cdef class SystemState:
             component_idx = spec.prescribed_element_indices[fixed_component_idx]
             self.mass_residual += abs(self.mole_fractions[component_idx] - spec.prescribed_elemental_amounts[fixed_component_idx])
 
-        for idx in range(len(self.compsets)):
-            compset = self.compsets[idx]
-            csst = self.cs_states[idx]
-            # TODO: Use better dof storage
-            # Calculate key phase quantities starting here
-            x = self.dof[idx]
-            csst.energy = 0
-            csst.mass_jac[:,:] = 0
-            # Compute phase matrix (LHS of Eq. 41, Sundman 2015)
-            csst.phase_matrix[:,:] = 0
-            csst.phase_rhs[:] = 0
-            csst.internal_cons[:] = 0
-            csst.full_e_matrix[:,:] = 0
-            for i in range(csst.full_e_matrix.shape[0]):
-                csst.full_e_matrix[i,i] = 1
-            csst.hess[:,:] = 0
-            csst.grad[:] = 0
-
-            compset.phase_record.formulaobj(<double[:1]>&csst.energy, x)
-            for comp_idx in range(num_components):
-                compset.phase_record.formulamole_grad(csst.mass_jac[comp_idx, :], x, comp_idx)
-            compset.phase_record.formulahess(csst.hess, x)
-            compset.phase_record.formulagrad(csst.grad, x)
-            compset.phase_record.internal_cons_func(csst.internal_cons, x)
-
-            compute_phase_matrix(csst.phase_matrix, csst.hess, compset, spec.num_statevars, self.chemical_potentials, x,
-                                 csst.fixed_phase_dof_indices)
-
-            # Compute right-hand side of Eq. 41, Sundman 2015
-            for i in range(compset.phase_record.phase_dof):
-                csst.phase_rhs[i] = -csst.grad[spec.num_statevars+i]
-                for sv_idx in range(spec.num_statevars):
-                    csst.phase_rhs[i] -= csst.hess[spec.num_statevars + i, sv_idx] * self.delta_statevars[sv_idx]
-                for comp_idx in range(num_components):
-                    csst.phase_rhs[i] += self.chemical_potentials[comp_idx] * csst.mass_jac[comp_idx, spec.num_statevars + i]
-
-            for cons_idx in range(compset.phase_record.num_internal_cons):
-                csst.phase_rhs[compset.phase_record.phase_dof + cons_idx] = -csst.internal_cons[cons_idx]
-
-            invert_matrix(&csst.phase_matrix[0,0], csst.phase_matrix.shape[0], &csst.full_e_matrix[0,0], &csst.ipiv[0])
-
-            num_phase_dof = compset.phase_record.phase_dof
-            csst.c_G[:] = 0
-            csst.c_statevars[:,:] = 0
-            csst.c_component[:,:] = 0
-            csst.moles_normalization = 0
-            csst.moles_normalization_grad[:] = 0
-            for i in range(num_phase_dof):
-                for j in range(num_phase_dof):
-                    csst.c_G[i] -= csst.full_e_matrix[i, j] * csst.grad[spec.num_statevars+j]
-            for i in range(num_phase_dof):
-                for j in range(num_phase_dof):
-                    for statevar_idx in range(spec.num_statevars):
-                        csst.c_statevars[i, statevar_idx] -= csst.full_e_matrix[i, j] * csst.hess[spec.num_statevars + j, statevar_idx]
+        for idx in range(self.num_compsets):
+            self._compute_compset_corrections(spec, <CompsetState>self.compset_states[idx],
+                                              <PhaseRecord>self.phase_records[idx], idx)
+
+    cdef void _compute_compset_masses(self, CompsetState csst, PhaseRecord prx, int idx, int num_components) noexcept nogil:
+        cdef double[::1] x = csst.x
+        cdef int comp_idx
+        csst.masses[:,:] = 0
+        for comp_idx in range(num_components):
+            prx.formulamole_obj(csst.masses[comp_idx, :], x, comp_idx)
+            if self.phase_amt[idx] > 0:
+                self.mole_fractions[comp_idx] += self.phase_amt[idx] * csst.masses[comp_idx, 0]
+                self.system_amount += self.phase_amt[idx] * csst.masses[comp_idx, 0]
+            self.phase_compositions[idx, comp_idx] = csst.masses[comp_idx, 0]
+
+    cdef void _compute_compset_corrections(self, SystemSpecification spec, CompsetState csst, PhaseRecord prx,
+                                           int idx) noexcept nogil:
+        cdef int num_components = spec.num_components
+        cdef int num_phase_dof = prx.phase_dof
+        cdef double[::1] x = csst.x
+        cdef double[:, ::1] rhs
+        cdef int comp_idx, cons_idx, i, j, sv_idx, statevar_idx
+        cdef double mu_c_sum
+        # Calculate key phase quantities starting here
+        csst.energy = 0
+        csst.mass_jac[:,:] = 0
+        # Compute phase matrix (LHS of Eq. 41, Sundman 2015)
+        csst.phase_matrix[:,:] = 0
+        csst.phase_rhs[:] = 0
+        csst.internal_cons[:] = 0
+        csst.hess[:,:] = 0
+        csst.grad[:] = 0
+
+        csst.energy_out[0] = 0
+        prx.formulaobj(csst.energy_out, x)
+        csst.energy = csst.energy_out[0]
+        for comp_idx in range(num_components):
+            prx.formulamole_grad(csst.mass_jac[comp_idx, :], x, comp_idx)
+        prx.formulahess(csst.hess, x)
+        prx.formulagrad(csst.grad, x)
+        prx.internal_cons_func(csst.internal_cons, x)
+
+        compute_phase_matrix(csst.phase_matrix, csst.hess, prx, spec.num_statevars, self.chemical_potentials, x,
+                             csst.fixed_phase_dof_indices, csst.cons_jac_tmp, csst.mass_hess_tmp)
+
+        # Compute right-hand side of Eq. 41, Sundman 2015
+        for i in range(num_phase_dof):
+            csst.phase_rhs[i] = -csst.grad[spec.num_statevars+i]
+            for sv_idx in range(spec.num_statevars):
+                csst.phase_rhs[i] -= csst.hess[spec.num_statevars + i, sv_idx] * self.delta_statevars[sv_idx]
             for comp_idx in range(num_components):
-                for i in range(num_phase_dof):
-                    for j in range(num_phase_dof):
-                        csst.c_component[comp_idx, i] += csst.mass_jac[comp_idx, spec.num_statevars + j] * csst.full_e_matrix[i, j]
+                csst.phase_rhs[i] += self.chemical_potentials[comp_idx] * csst.mass_jac[comp_idx, spec.num_statevars + i]
+
+        for cons_idx in range(prx.num_internal_cons):
+            csst.phase_rhs[num_phase_dof + cons_idx] = -csst.internal_cons[cons_idx]
+
+        # c_G, c_statevars and c_component (Eq. 43, Sundman 2015) are all products of the inverse phase matrix
+        # with a vector padded by zeros in the constraint rows, so factor the phase matrix once and solve for them
+        # together instead of forming the inverse
+        rhs = csst.correction_rhs
+        for i in range(rhs.shape[0]):
+            for j in range(rhs.shape[1]):
+                rhs[i, j] = 0
+        for j in range(num_phase_dof):
+            rhs[0, j] = csst.grad[spec.num_statevars + j]
+            for statevar_idx in range(spec.num_statevars):
+                rhs[1 + statevar_idx, j] = csst.hess[spec.num_statevars + j, statevar_idx]
             for comp_idx in range(num_components):
-                for i in range(num_phase_dof):
-                    mu_c_sum = 0
-                    for j in range(self.chemical_potentials.shape[0]):
-                        mu_c_sum += csst.c_component[j, i] * self.chemical_potentials[j]
-                    self.delta_ms[idx, comp_idx] += csst.mass_jac[comp_idx, spec.num_statevars + i] * (mu_c_sum + csst.c_G[i])
+                rhs[1 + spec.num_statevars + comp_idx, j] = csst.mass_jac[comp_idx, spec.num_statevars + j]
+        lu_solve(&csst.phase_matrix[0,0], csst.phase_matrix.shape[0], &rhs[0,0], rhs.shape[0], &csst.ipiv[0])
+
+        csst.moles_normalization = 0
+        csst.moles_normalization_grad[:] = 0
+        for i in range(num_phase_dof):
+            csst.c_G[i] = -rhs[0, i]
+            for statevar_idx in range(spec.num_statevars):
+                csst.c_statevars[i, statevar_idx] = -rhs[1 + statevar_idx, i]
             for comp_idx in range(num_components):
-                csst.moles_normalization += csst.masses[comp_idx, 0]
-                for i in range(num_phase_dof+spec.num_statevars):
-                    csst.moles_normalization_grad[i] += csst.mass_jac[comp_idx, i]
-
-
-cpdef take_step(SystemSpecification spec, SystemState state, double step_size):
+                csst.c_component[comp_idx, i] = rhs[1 + spec.num_statevars + comp_idx, i]
+        for comp_idx in range(num_components):
+            for i in range(num_phase_dof):
+                mu_c_sum = 0
+                for j in range(self.chemical_potentials.shape[0]):
+                    mu_c_sum += csst.c_component[j, i] * self.chemical_potentials[j]
+                self.delta_ms[idx, comp_idx] += csst.mass_jac[comp_idx, spec.num_statevars + i] * (mu_c_sum + csst.c_G[i])
+        for comp_idx in range(num_components):
+            csst.moles_normalization += csst.masses[comp_idx, 0]
+            for i in range(num_phase_dof+spec.num_statevars):
+                csst.moles_normalization_grad[i] += csst.mass_jac[comp_idx, i]
+
+
+cdef double advance_compset_dof(SystemSpecification spec, SystemState state, CompsetState csst, PhaseRecord prx,
+                                double step_size, double* largest_internal_cons_max_residual,
+                                double* largest_internal_dof_change) noexcept nogil:
+    "Step the internal degrees of freedom of one composition set; returns the step size after backtracking."
+    cdef double[::1] x = csst.x
+    cdef double[::1] delta_y = csst.delta_y
+    cdef double[::1] new_y = csst.new_y
+    cdef double[::1] delta_statevars = state.statevar_step
+    cdef double internal_cons_max_residual = 0
+    cdef double minimum_step_size
+    cdef bint exceeded_bounds
+    cdef int i, sv_idx, cp_idx, cons_idx
+    # recompute() already evaluated the internal constraints at x
+    for cons_idx in range(prx.num_internal_cons):
+        internal_cons_max_residual = max(internal_cons_max_residual, abs(csst.internal_cons[cons_idx]))
+
+    # Construct delta_y from Eq. 43 in Sundman 2015
+    # TODO: needs charge balance contribution
+    for i in range(delta_y.shape[0]):
+        delta_y[i] = csst.c_G[i]
+        for sv_idx in range(delta_statevars.shape[0]):
+            delta_y[i] += csst.c_statevars[i, sv_idx] * delta_statevars[sv_idx]
+        for cp_idx in range(state.chemical_potentials.shape[0]):
+            delta_y[i] += csst.c_component[cp_idx, i] * state.chemical_potentials[cp_idx]
+
+    largest_internal_cons_max_residual[0] = max(largest_internal_cons_max_residual[0], internal_cons_max_residual)
+    new_y[:] = x
+    minimum_step_size = 1e-20 * step_size
+    while step_size >= minimum_step_size:
+        exceeded_bounds = False
+        for i in range(spec.num_statevars, new_y.shape[0]):
+            new_y[i] = x[i] + step_size * delta_y[i - spec.num_statevars]
+            if new_y[i] > 1:
+                if (new_y[i] - 1) > 1e-11:
+                    # Allow some tolerance in the name of progress
+                    exceeded_bounds = True
+                new_y[i] = 1
+            elif new_y[i] < _MIN_SITE_FRACTION:
+                if (_MIN_SITE_FRACTION - new_y[i]) > 1e-11:
+                    # Allow some tolerance in the name of progress
+                    exceeded_bounds = True
+                # Reduce by two orders of magnitude, or MIN_SITE_FRACTION, whichever is larger
+                new_y[i] = max(x[i]/100, _MIN_SITE_FRACTION)
+        if exceeded_bounds:
+            step_size *= 0.5
+            continue
+        break
+
+    for i in range(spec.num_statevars, new_y.shape[0]):
+        largest_internal_dof_change[0] = max(largest_internal_dof_change[0], abs(new_y[i] - x[i]))
+    x[:] = new_y
+    return step_size
+
+
+cdef bint _take_step(SystemSpecification spec, SystemState state, double step_size) noexcept nogil:
+    "Advance the state by one Newton step. Returns False, without changing the state, if the conditions do not obey the Gibbs phase rule."
     cdef double largest_internal_cons_max_residual = 0
     cdef double largest_internal_dof_change = 0
-    cdef double internal_cons_max_residual, minimum_step_size
-    cdef double[::1] cons_tmp
-    cdef double[::1] delta_statevars = np.zeros(spec.num_statevars)
-    cdef double[::1] delta_y
+    cdef double[::1] delta_statevars = state.statevar_step
     cdef double[::1,:] equilibrium_matrix  # Fortran ordering required by call into lapack
-    cdef double[::1] equilibrium_rhs, equilibrium_soln, old_chemical_potentials, new_y, x
-    cdef CompositionSet compset
-    cdef CompsetState csst
-    cdef bint exceeded_bounds
-    cdef int i, comp_idx, cp_idx, idx, num_stable_phases, num_fixed_phases, num_fixed_components, num_free_variables
+    cdef double[::1] equilibrium_soln, old_chemical_potentials
+    cdef int i, j, comp_idx, cp_idx, num_stable_phases, num_fixed_phases, num_fixed_components
+    cdef int num_free_variables, num_equations
 
     # STEP 1: Solve the equilibrium matrix (chemical potentials, corrections to phase amounts and state variables)
     state.largest_internal_cons_max_residual = largest_internal_cons_max_residual
@@ -622,114 +1049,302 @@ cpdef take_step(SystemSpecification spec, SystemState state, double step_size):
 
     num_stable_phases = state.free_stable_compset_indices.shape[0]
     num_fixed_phases = spec.fixed_stable_compset_indices.shape[0]
-    num_fixed_components = len(spec.prescribed_elemental_amounts)
+    num_fixed_components = spec.prescribed_elemental_amounts.shape[0]
     num_free_variables = spec.free_chemical_potential_indices.shape[0] + num_stable_phases + \
                          spec.free_statevar_indices.shape[0]
-
-    equilibrium_matrix = np.zeros((num_stable_phases + num_fixed_phases + num_fixed_components + 1, num_free_variables), order='F')
-    equilibrium_soln = np.zeros(num_stable_phases + num_fixed_phases + num_fixed_components + 1)
-    if (num_stable_phases + num_fixed_phases + num_fixed_components + 1) != num_free_variables:
-        raise ValueError('Conditions do not obey Gibbs Phase Rule')
-
-    equilibrium_matrix[:,:] = 0
+    num_equations = num_stable_phases + num_fixed_phases + num_fixed_components + 1
+
+    if num_equations != num_free_variables:
+        return False
+    # Views into the preallocated workspace; the solve is told the leading dimension of the full buffer
+    equilibrium_matrix = state.equilibrium_matrix[:num_equations, :num_free_variables]
+    equilibrium_soln = state.equilibrium_soln[:num_equations]
+
+    # The view is strided in its second dimension, so clear it element-wise rather than by slice assignment
+    for j in range(num_free_variables):
+        for i in range(num_equations):
+            equilibrium_matrix[i, j] = 0
     equilibrium_soln[:] = 0
     fill_equilibrium_system(equilibrium_matrix, equilibrium_soln, spec, state)
 
-    lstsq(&equilibrium_matrix[0,0], equilibrium_matrix.shape[0], equilibrium_matrix.shape[1],
-          &equilibrium_soln[0], -1)
-    old_chemical_potentials = np.array(state.chemical_potentials)
+    state.solve_equilibrium_system(num_equations, num_free_variables)
+    old_chemical_potentials = state.previous_chemical_potentials
+    old_chemical_potentials[:] = state.chemical_potentials
 
     # STEP 2: Advance the system state
     # Extract chemical potentials and update phase amounts
     extract_equilibrium_solution(state.chemical_potentials, state.phase_amt, delta_statevars,
                                  spec.free_chemical_potential_indices, spec.free_statevar_indices,
                                  state.free_stable_compset_indices, equilibrium_soln,
-                                 state.largest_statevar_change, state.largest_phase_amt_change, state.dof)
+                                 &state.largest_statevar_change[0], &state.largest_phase_amt_change[0],
+                                 (<CompsetState>state.compset_states[0]).x)
 
     # Force some chemical potentials to adopt their fixed values
     for cp_idx in range(spec.fixed_chemical_potential_indices.shape[0]):
         comp_idx = spec.fixed_chemical_potential_indices[cp_idx]
         state.chemical_potentials[comp_idx] = spec.initial_chemical_potentials[comp_idx]
-    state.chempot_diff = np.array(state.chemical_potentials) - old_chemical_potentials
+    for comp_idx in range(state.chemical_potentials.shape[0]):
+        state.chempot_diff[comp_idx] = state.chemical_potentials[comp_idx] - old_chemical_potentials[comp_idx]
 
-    # Update phase internal degrees of freedom
-    for idx, compset in enumerate(state.compsets):
-        # TODO: Use better dof storage
-        x = state.dof[idx]
-        csst = state.cs_states[idx]
-        internal_cons_max_residual = 0
-        cons_tmp = np.zeros(compset.phase_record.num_internal_cons)
-        compset.phase_record.internal_cons_func(cons_tmp, x)
-        for cons_idx in range(compset.phase_record.num_internal_cons):
-            internal_cons_max_residual = max(internal_cons_max_residual, abs(cons_tmp[cons_idx]))
-
-        # Construct delta_y from Eq. 43 in Sundman 2015
-        # TODO: needs charge balance contribution
-        delta_y = np.zeros(compset.phase_record.phase_dof)
-        for i in range(delta_y.shape[0]):
-            delta_y[i] += csst.c_G[i]
-            for sv_idx in range(delta_statevars.shape[0]):
-                delta_y[i] += csst.c_statevars[i, sv_idx] * delta_statevars[sv_idx]
-            for cp_idx in range(state.chemical_potentials.shape[0]):
-                delta_y[i] += csst.c_component[cp_idx, i] * state.chemical_potentials[cp_idx]
-
-        largest_internal_cons_max_residual = max(largest_internal_cons_max_residual, internal_cons_max_residual)
-        new_y = np.array(x)
-        minimum_step_size = 1e-20 * step_size
-        while step_size >= minimum_step_size:
-            exceeded_bounds = False
-            for i in range(spec.num_statevars, new_y.shape[0]):
-                new_y[i] = x[i] + step_size * delta_y[i - spec.num_statevars]
-                if new_y[i] > 1:
-                    if (new_y[i] - 1) > 1e-11:
-                        # Allow some tolerance in the name of progress
-                        exceeded_bounds = True
-                    new_y[i] = 1
-                elif new_y[i] < MIN_SITE_FRACTION:
-                    if (MIN_SITE_FRACTION - new_y[i]) > 1e-11:
-                        # Allow some tolerance in the name of progress
-                        exceeded_bounds = True
-                    # Reduce by two orders of magnitude, or MIN_SITE_FRACTION, whichever is larger
-                    new_y[i] = max(x[i]/100, MIN_SITE_FRACTION)
-            if exceeded_bounds:
-                step_size *= 0.5
-                continue
-            break
+    _advance_dof(spec, state, step_size, &largest_internal_cons_max_residual, &largest_internal_dof_change)
+    state.largest_internal_cons_max_residual = largest_internal_cons_max_residual
+    state.largest_internal_dof_change = largest_internal_dof_change
+    return True
 
-        for i in range(spec.num_statevars, new_y.shape[0]):
-            largest_internal_dof_change = max(largest_internal_dof_change, abs(new_y[i] - x[i]))
-        x[:] = new_y
+
+cdef void _advance_dof(SystemSpecification spec, SystemState state, double step_size,
+                       double* largest_internal_cons_max_residual, double* largest_internal_dof_change) noexcept nogil:
+    "Move the internal degrees of freedom and state variables along the step solved for by _take_step."
+    cdef double[::1] delta_statevars = state.statevar_step
+    cdef double[::1] x
+    cdef int idx, sv_idx
+    # Update phase internal degrees of freedom
+    # The step size shrinks as composition sets hit their bounds, and carries over to the next one
+    for idx in range(state.num_compsets):
+        step_size = advance_compset_dof(spec, state, <CompsetState>state.compset_states[idx],
+                                        <PhaseRecord>state.phase_records[idx], step_size,
+                                        largest_internal_cons_max_residual, largest_internal_dof_change)
 
     # Update state variables
-    for idx in range(len(state.compsets)):
-        x = state.dof[idx]
+    for idx in range(state.num_compsets):
+        x = (<CompsetState>state.compset_states[idx]).x
         for sv_idx in range(delta_statevars.shape[0]):
             x[sv_idx] += delta_statevars[sv_idx]
         # We need real state variable bounds support
 
 
+# Backtracking line search parameters: sufficient decrease coefficient and maximum number of halvings
+cdef double LINE_SEARCH_ARMIJO = 1e-4
+cdef int LINE_SEARCH_MAX_BACKTRACKS = 8
+
+
+cdef double _line_search(SystemSpecification spec, SystemState state, SystemState old_state, double step_size,
+                         double tolerance) noexcept nogil:
+    """
+    Halve the internal degree of freedom step just taken from old_state until the mass balance merit decreases
+    sufficiently, or is below tolerance. Chemical potentials, phase amounts and state variables keep their full
+    Newton step. The last trial step is kept if none is accepted. Returns the accepted step size.
+    """
+    cdef double initial_merit = old_state.mass_balance_merit(spec)
+    cdef double merit
+    cdef double largest_internal_cons_max_residual = 0
+    cdef double largest_internal_dof_change = 0
+    cdef int backtrack
+    for backtrack in range(LINE_SEARCH_MAX_BACKTRACKS):
+        merit = state.mass_balance_merit(spec)
+        if (merit <= tolerance) or (merit <= (1 - LINE_SEARCH_ARMIJO * step_size) * initial_merit):
+            break
+        step_size *= 0.5
+        state.copy_dof_from(old_state)
+        # Restores the state variables too; _advance_dof applies their full step again
+        _advance_dof(spec, state, step_size, &largest_internal_cons_max_residual, &largest_internal_dof_change)
+    return step_size
+
+
+cpdef take_step(SystemSpecification spec, SystemState state, double step_size):
+    cdef bint valid_conditions
+    with nogil:
+        valid_conditions = _take_step(spec, state, step_size)
+    if not valid_conditions:
+        raise ValueError('Conditions do not obey Gibbs Phase Rule')
+
+
+cdef enum NewtonStatus:
+    NEWTON_CONTINUE = 0
+    NEWTON_FEASIBLE = 1
+    NEWTON_INVALID_CONDITIONS = 2
+
+
+cdef int _newton_iteration(SystemSpecification spec, SystemState state, SystemState old_state, int iteration,
+                           double* step_size, int phase_change_counter, int min_feasible_iteration,
+                           double[::1] chemical_potentials, double allowed_mass_residual, double[::1] delta_m,
+                           int[::1] phase_ids, int[::1] compsets_to_remove) noexcept nogil:
+    """
+    Run one iteration of find_solution, up to the point where the stable phase set may change.
+    The solution is not considered feasible before iteration min_feasible_iteration.
+    phase_ids identifies composition sets of the same phase, and is -1 for fixed composition sets.
+    chemical_potentials are those of the previous iteration. step_size is updated for the next iteration.
+    Returns a NewtonStatus.
+    """
+    cdef int num_components = spec.num_components
+    cdef int idx, idx2, j, cp_idx, comp_idx, phase_idx, num_kept_phases
+    cdef double delta_energy, compset_distance, chempot_diff, largest_moles_change
+    cdef bint chempots_settled
+    state.iteration = iteration
+    if (state.mass_residual > 10) and (_max_abs(&state.chemical_potentials[0], num_components) > 1.0e10):
+        state.chemical_potentials[:] = spec.initial_chemical_potentials
+
+    old_state.copy_from(state)
+    if state.line_search:
+        old_state.copy_dof_from(state)
+    if not _take_step(spec, state, step_size[0]):
+        return NEWTON_INVALID_CONDITIONS
+    if state.line_search:
+        step_size[0] = _line_search(spec, state, old_state, step_size[0], allowed_mass_residual)
+    state.step_size = step_size[0]
+    chempots_settled = True
+    for comp_idx in range(num_components):
+        if not (state.chempot_diff[comp_idx] < 1.0):
+            chempots_settled = False
+            break
+    if ((state.mass_residual > 1e-2) and (not chempots_settled)) or (iteration == 0):
+        # When mass residual is not satisfied, do not allow phases to leave the system
+        # However, if the chemical potentials are changing very little, phases may leave the system
+        for j in range(state.phase_amt.shape[0]):
+            if state.phase_amt[j] < 0:
+                state.phase_amt[j] = 1e-8
+    delta_m[:] = 0
+    for idx in range(state.phase_compositions.shape[0]):
+        for j in range(state.phase_compositions.shape[1]):
+            delta_m[j] += state.phase_amt[idx] * state.phase_compositions[idx, j] - old_state.phase_amt[idx] * old_state.phase_compositions[idx, j]
+    delta_energy = 0
+    for j in range(num_components):
+        delta_energy += old_state.chemical_potentials[j] * abs(delta_m[j])
+    delta_energy = abs(delta_energy)
+    if delta_energy == 0:
+            delta_energy = 1e-10
+    if state.line_search:
+        # Always try the full Newton step; _line_search backtracks from it
+        step_size[0] = 1
+    elif state.mass_residual < 1e-2:
+        step_size[0] = min(1, 1./delta_energy)
+    else:
+        step_size[0] = 1./10
+
+    # Consolidate duplicate phases and remove unstable phases
+    compsets_to_remove[:] = 0
+    for idx in range(state.num_compsets):
+        if phase_ids[idx] < 0:
+            continue
+        if compsets_to_remove[idx]:
+            continue
+        if state.phase_amt[idx] < 1e-10:
+            compsets_to_remove[idx] = 1
+            continue
+        for idx2 in range(state.num_compsets):
+            if idx == idx2:
+                continue
+            # Also skips fixed composition sets
+            if phase_ids[idx2] != phase_ids[idx]:
+                continue
+            if compsets_to_remove[idx2]:
+                continue
+            compset_distance = 0
+            for j in range(num_components):
+                compset_distance = max(compset_distance, abs(state.phase_compositions[idx, j] - state.phase_compositions[idx2, j]))
+            if compset_distance < 1e-4:
+                compsets_to_remove[idx2] = 1
+                # compset is not fixed here, so it absorbs the duplicate's amount
+                state.phase_amt[idx] += state.phase_amt[idx2]
+                state.phase_amt[idx2] = 0
+    # free_stable_compset_indices is kept sorted, so filtering it in place preserves order
+    num_kept_phases = 0
+    for j in range(state.free_stable_compset_indices.shape[0]):
+        if not compsets_to_remove[state.free_stable_compset_indices[j]]:
+            num_kept_phases += 1
+    if num_kept_phases == 0:
+        # Do not allow all phases to leave the system
+        for j in range(state.free_stable_compset_indices.shape[0]):
+            phase_idx = state.free_stable_compset_indices[j]
+            state.phase_amt[phase_idx] = 1
+        state.chemical_potentials[:] = 0
+        # Force some chemical potentials to adopt their fixed values
+        for cp_idx in range(spec.fixed_chemical_potential_indices.shape[0]):
+            comp_idx = spec.fixed_chemical_potential_indices[cp_idx]
+            state.chemical_potentials[comp_idx] = spec.initial_chemical_potentials[comp_idx]
+    elif num_kept_phases < state.free_stable_compset_indices.shape[0]:
+        num_kept_phases = 0
+        for j in range(state.free_stable_compset_indices.shape[0]):
+            phase_idx = state.free_stable_compset_indices[j]
+            if not compsets_to_remove[phase_idx]:
+                state.free_stable_compset_indices[num_kept_phases] = phase_idx
+                num_kept_phases += 1
+        state.set_free_stable_compset_indices(state.free_stable_compset_indices[:num_kept_phases])
+    for idx in range(state.phase_amt.shape[0]):
+        if state.phase_amt[idx] < 0.0:
+            state.phase_amt[idx] = 0
+
+    # Only include chemical potential difference if chemical potential conditions were enabled
+    # XXX: This really should be a condition defined in terms of delta_m, because chempot_diff is only necessary
+    # because mass_residual is no longer driving convergence for partially/fully open systems
+    if spec.fixed_chemical_potential_indices.shape[0] > 0:
+        chempot_diff = _max_relative_change(state.chemical_potentials, chemical_potentials)
+    else:
+        chempot_diff = 0.0
+    largest_moles_change = _max_abs(&state.delta_ms[0, 0], state.delta_ms.shape[0] * state.delta_ms.shape[1])
+    state.largest_moles_change = largest_moles_change
+    # Wait for mass balance to be satisfied before changing phases
+    # Phases that "want" to be removed will keep having their phase_amt set to zero, so mass balance is unaffected
+    if (state.mass_residual < allowed_mass_residual) and (state.largest_internal_cons_max_residual < 1e-9) and \
+            (chempot_diff < 1e-12) and (state.iteration >= min_feasible_iteration) and (largest_moles_change < 1e-9) and (phase_change_counter == 0):
+        return NEWTON_FEASIBLE
+    return NEWTON_CONTINUE
+
+
+cdef void _record_iteration(double[:, ::1] trace, int iteration, SystemState state, bint phase_set_changed) noexcept nogil:
+    "Write the CONVERGENCE_TRACE_DTYPE fields of this iteration into its row of the trace ring buffer."
+    cdef int row = iteration % trace.shape[0]
+    trace[row, 0] = iteration
+    trace[row, 1] = state.mass_residual
+    trace[row, 2] = state.largest_internal_cons_max_residual
+    trace[row, 3] = state.largest_moles_change
+    trace[row, 4] = state.step_size
+    trace[row, 5] = state.free_stable_compset_indices.shape[0]
+    trace[row, 6] = phase_set_changed
+
+
+def convergence_trace(trace, num_iterations):
+    "Convert the trace ring buffer of find_solution to a CONVERGENCE_TRACE_DTYPE array, oldest iteration first."
+    trace = np.asarray(trace)
+    if trace.shape[0] == 0:
+        return np.empty(0, dtype=CONVERGENCE_TRACE_DTYPE)
+    first_iteration = max(0, num_iterations - trace.shape[0])
+    rows = trace[np.arange(first_iteration, num_iterations) % trace.shape[0]]
+    result = np.empty(rows.shape[0], dtype=CONVERGENCE_TRACE_DTYPE)
+    for col, name in enumerate(CONVERGENCE_TRACE_DTYPE.names):
+        result[name] = rows[:, col]
+    return result
+
+
 cpdef find_solution(list compsets, int num_statevars, int num_components,
                     double prescribed_system_amount, double[::1] initial_chemical_potentials,
                     int[::1] free_chemical_potential_indices, int[::1] fixed_chemical_potential_indices,
                     int[::1] prescribed_element_indices, double[::1] prescribed_elemental_amounts,
-                    int[::1] free_statevar_indices, int[::1] fixed_statevar_indices):
-    cdef int iteration, idx, idx2, comp_idx, phase_idx, i
-    cdef int num_stable_phases, num_fixed_components, num_free_variables
-    cdef CompositionSet compset, compset2
-    cdef double mass_residual = 1e-30
-    cdef double max_delta_m, delta_energy, allowed_mass_residual
-    cdef double[::1] x, new_y, delta_y
+                    int[::1] free_statevar_indices, int[::1] fixed_statevar_indices, bint use_qr=False,
+                    bint dense_assembly=False, bint line_search=False, int trace_length=64,
+                    warm_start_chemical_potentials=None, warm_start_phase_amounts=None,
+                    warm_start_stable_compset_indices=None, bint trust_warm_start=False):
+    """
+    Returns (converged, x, chemical_potentials, iterations, trace), where trace records the last trace_length
+    Newton iterations as a CONVERGENCE_TRACE_DTYPE array.
+    The warm_start_* arguments seed the free chemical potentials, the phase fractions of each composition set
+    and the free stable composition sets, typically from a previous solution. Without
+    warm_start_stable_compset_indices, the free stable composition sets are those with a positive warm-start
+    phase amount; if no free composition set has a positive amount, the warm-start phase amounts are ignored
+    and the default stable set is kept. If trust_warm_start is set, the warm-up heuristics (initial damped
+    steps and the delays before phases may change) are skipped.
+    """
+    cdef int iteration, idx, comp_idx, i, phase_change_counter, min_feasible_iteration, min_phase_add_iteration
+    cdef CompositionSet compset
+    cdef int status
+    cdef double allowed_mass_residual, step_size
+    cdef double[::1] x
     cdef double[::1] delta_m = np.zeros(num_components)
     cdef double[::1] chemical_potentials = np.zeros(num_components)
     cdef int[::1] fixed_stable_compset_indices = np.array(np.nonzero([compset.fixed==True for compset in compsets])[0],
                                                           dtype=np.int32)
-    cdef list dof = [np.array(compset.dof) for compset in compsets]
-    cdef list suspended_compsets = []
     cdef int[::1] stable_phase_iterations = np.zeros(len(compsets), dtype=np.int32)
     cdef int[::1] metastable_phase_iterations = np.zeros(len(compsets), dtype=np.int32)
     cdef int[::1] times_compset_removed = np.zeros(len(compsets), dtype=np.int32)
+    # Per-iteration flags, indexed by composition set
+    cdef int[::1] compsets_to_remove = np.zeros(len(compsets), dtype=np.int32)
+    cdef int[::1] is_free_stable = np.zeros(len(compsets), dtype=np.int32)
+    cdef int[::1] was_free_stable = np.zeros(len(compsets), dtype=np.int32)
+    cdef int[::1] phase_ids = np.empty(len(compsets), dtype=np.int32)
+    cdef dict phase_name_ids = {}
     cdef bint converged = False
-    cdef int max_dof = num_statevars + max([compset.phase_record.phase_dof for compset in compsets])
+    cdef bint phase_set_changed
+    cdef double[:, ::1] trace = np.zeros((trace_length, len(CONVERGENCE_TRACE_DTYPE.names)))
     cdef SystemSpecification spec = SystemSpecification(num_statevars, num_components, prescribed_system_amount,
                                                         initial_chemical_potentials, prescribed_elemental_amounts,
                                                         prescribed_element_indices,
@@ -737,7 +1352,19 @@ cpdef find_solution(list compsets, int num_statevars, int num_components,
                                                         fixed_chemical_potential_indices, fixed_statevar_indices,
                                                         fixed_stable_compset_indices)
     cdef SystemState state = SystemState(spec, compsets)
-    cdef SystemState old_state
+    # Second buffer holding the state at the start of the current step
+    cdef SystemState old_state = SystemState(spec, compsets)
+    state.use_qr = use_qr
+    state.dense_assembly = dense_assembly
+    state.line_search = line_search
+
+    # Composition sets of the same phase may be merged; fixed composition sets never are
+    for idx in range(len(compsets)):
+        compset = compsets[idx]
+        if compset.fixed:
+            phase_ids[idx] = -1
+        else:
+            phase_ids[idx] = phase_name_ids.setdefault(compset.phase_record.phase_name, len(phase_name_ids))
 
     if spec.prescribed_elemental_amounts.shape[0] > 0:
         allowed_mass_residual = min(1e-8, np.min(spec.prescribed_elemental_amounts)/10)
@@ -745,93 +1372,55 @@ cpdef find_solution(list compsets, int num_statevars, int num_components,
         allowed_mass_residual = min(allowed_mass_residual, (1-np.sum(spec.prescribed_elemental_amounts))/10)
     else:
         allowed_mass_residual = 1e-8
+    if warm_start_chemical_potentials is not None:
+        for i in range(spec.free_chemical_potential_indices.shape[0]):
+            comp_idx = spec.free_chemical_potential_indices[i]
+            state.chemical_potentials[comp_idx] = warm_start_chemical_potentials[comp_idx]
+        for i in range(spec.fixed_chemical_potential_indices.shape[0]):
+            comp_idx = spec.fixed_chemical_potential_indices[i]
+            state.chemical_potentials[comp_idx] = spec.initial_chemical_potentials[comp_idx]
+        chemical_potentials = np.array(state.chemical_potentials)
+    if warm_start_stable_compset_indices is None and warm_start_phase_amounts is not None:
+        # Composition sets seeded with a positive amount are the free stable ones
+        warm_start_stable_compset_indices = sorted(set(np.nonzero(np.asarray(warm_start_phase_amounts) > 0)[0]) -
+                                                   set(np.asarray(fixed_stable_compset_indices)))
+        if len(warm_start_stable_compset_indices) == 0:
+            # No free composition set is seeded as stable: keep the default amounts and stable set
+            warm_start_phase_amounts = None
+            warm_start_stable_compset_indices = None
+    if warm_start_phase_amounts is not None:
+        for idx in range(state.num_compsets):
+            # Convert phase fractions to formula units
+            state.phase_amt[idx] = warm_start_phase_amounts[idx] / np.sum(state.phase_compositions[idx])
+    if warm_start_stable_compset_indices is not None:
+        state.set_free_stable_compset_indices(np.array(sorted(set(warm_start_stable_compset_indices) -
+                                                              set(np.asarray(fixed_stable_compset_indices))), dtype=np.int32))
+    for i in range(state.free_stable_compset_indices.shape[0]):
+        is_free_stable[state.free_stable_compset_indices[i]] = 1
     state.mass_residual = 1e10
-    phase_change_counter = 5
-    step_size = 1./10
+    if trust_warm_start:
+        # The seed is already close to the solution: take full steps, and let phases change immediately
+        phase_change_counter = 0
+        step_size = 1
+        min_feasible_iteration = 0
+        min_phase_add_iteration = 0
+        for idx in range(state.num_compsets):
+            if not is_free_stable[idx]:
+                metastable_phase_iterations[idx] = 5
+    else:
+        phase_change_counter = 5
+        step_size = 1./10
+        min_feasible_iteration = 6
+        min_phase_add_iteration = 4
     for iteration in range(1000):
-        state.iteration = iteration
-        if (state.mass_residual > 10) and (np.max(np.abs(state.chemical_potentials)) > 1.0e10):
-            state.chemical_potentials[:] = spec.initial_chemical_potentials
-
-        old_state = copy(state)
-        take_step(spec, state, step_size)
-        delta_phase_amt = np.array(state.phase_amt) - np.array(old_state.phase_amt)
-        if ((state.mass_residual > 1e-2) and (not np.all(np.array(state.chempot_diff) < 1.0))) or (iteration == 0):
-            # When mass residual is not satisfied, do not allow phases to leave the system
-            # However, if the chemical potentials are changing very little, phases may leave the system
-            for j in range(state.phase_amt.shape[0]):
-                if state.phase_amt[j] < 0:
-                    state.phase_amt[j] = 1e-8
-        delta_m[:] = 0
-        max_delta_m = 0
-        for idx in range(state.phase_compositions.shape[0]):
-            for j in range(state.phase_compositions.shape[1]):
-                delta_m[j] += state.phase_amt[idx] * state.phase_compositions[idx, j] - old_state.phase_amt[idx] * old_state.phase_compositions[idx, j]
-        delta_energy = np.abs(np.dot(old_state.chemical_potentials, np.abs(delta_m)))
-        if delta_energy == 0:
-                delta_energy = 1e-10
-        if state.mass_residual < 1e-2:
-            step_size = min(1, 1./delta_energy)
-        else:
-            step_size = 1./10
-
-        # Consolidate duplicate phases and remove unstable phases
-        compsets_to_remove = set()
-        for idx in range(len(state.compsets)):
-            compset = state.compsets[idx]
-            if compset.fixed:
-                continue
-            if idx in compsets_to_remove:
-                continue
-            if state.phase_amt[idx] < 1e-10:
-                compsets_to_remove.add(idx)
-                continue
-            for idx2 in range(len(compsets)):
-                compset2 = compsets[idx2]
-                if idx == idx2:
-                    continue
-                if idx2 in spec.fixed_stable_compset_indices:
-                    continue
-                if compset.phase_record.phase_name != compset2.phase_record.phase_name:
-                    continue
-                if idx2 in compsets_to_remove:
-                    continue
-                compset_distance = np.max(np.abs(np.array(state.phase_compositions[idx]) - np.array(state.phase_compositions[idx2])))
-                if compset_distance < 1e-4:
-                    compsets_to_remove.add(idx2)
-                    if idx not in spec.fixed_stable_compset_indices:
-                        state.phase_amt[idx] += state.phase_amt[idx2]
-                    state.phase_amt[idx2] = 0
-        new_free_stable_compset_indices = np.array(sorted(set(state.free_stable_compset_indices) - set(compsets_to_remove)), dtype=np.int32)
-        if len(new_free_stable_compset_indices) == 0:
-            # Do not allow all phases to leave the system
-            for phase_idx in state.free_stable_compset_indices:
-                state.phase_amt[phase_idx] = 1
-            state.chemical_potentials[:] = 0
-            # Force some chemical potentials to adopt their fixed values
-            for cp_idx in range(spec.fixed_chemical_potential_indices.shape[0]):
-                comp_idx = spec.fixed_chemical_potential_indices[cp_idx]
-                state.chemical_potentials[comp_idx] = spec.initial_chemical_potentials[comp_idx]
-        else:
-            state.free_stable_compset_indices = new_free_stable_compset_indices
-        for dof_idx in range(state.phase_amt.shape[0]):
-            if state.phase_amt[dof_idx] < 0.0:
-                state.phase_amt[dof_idx] = 0
-
-        # Only include chemical potential difference if chemical potential conditions were enabled
-        # XXX: This really should be a condition defined in terms of delta_m, because chempot_diff is only necessary
-        # because mass_residual is no longer driving convergence for partially/fully open systems
-        if spec.fixed_chemical_potential_indices.shape[0] > 0:
-            chempot_diff = np.max(np.abs(np.array(state.chemical_potentials)/np.array(chemical_potentials) - 1))
-        else:
-            chempot_diff = 0.0
-        largest_moles_change = np.max(np.abs(state.delta_ms))
+        with nogil:
+            status = _newton_iteration(spec, state, old_state, iteration, &step_size, phase_change_counter,
+                                       min_feasible_iteration, chemical_potentials, allowed_mass_residual, delta_m,
+                                       phase_ids, compsets_to_remove)
+        if status == NEWTON_INVALID_CONDITIONS:
+            raise ValueError('Conditions do not obey Gibbs Phase Rule')
         chemical_potentials = state.chemical_potentials
-        # Wait for mass balance to be satisfied before changing phases
-        # Phases that "want" to be removed will keep having their phase_amt set to zero, so mass balance is unaffected
-        system_is_feasible = (state.mass_residual < allowed_mass_residual) and (state.largest_internal_cons_max_residual < 1e-9) and \
-                             (chempot_diff < 1e-12) and (state.iteration > 5) and (largest_moles_change < 1e-9) and (phase_change_counter == 0)
-        if system_is_feasible:
+        if status == NEWTON_FEASIBLE:
             # Check driving forces for metastable phases
             # This needs to be done per mole of atoms, not per formula unit, since we compare phases to each other
             driving_forces = np.zeros(len(state.compsets))
@@ -844,32 +1433,45 @@ cpdef find_solution(list compsets, int num_statevars, int num_components,
                     compset.phase_record.mass_obj(phase_amounts_per_mole_atoms[idx, comp_idx, :], x, comp_idx)
                 compset.phase_record.obj(phase_energies_per_mole_atoms[idx, :], x)
                 driving_forces[idx] =  np.dot(chemical_potentials, phase_amounts_per_mole_atoms[idx, :, 0]) - phase_energies_per_mole_atoms[idx, 0]
-            converged, new_free_stable_compset_indices = \
+            converged, next_free_stable_compset_indices = \
                 check_convergence_and_change_phases(state.phase_amt, state.free_stable_compset_indices, metastable_phase_iterations,
-                                                    times_compset_removed, driving_forces, iteration > 3)
+                                                    times_compset_removed, driving_forces,
+                                                    iteration >= min_phase_add_iteration)
             # Force some amount of newly stable phases
-            for idx in new_free_stable_compset_indices:
+            for idx in next_free_stable_compset_indices:
                 if state.phase_amt[idx] < 1e-10:
                     state.phase_amt[idx] = 1e-10
             # Force unstable phase amounts to zero
             for idx in range(state.phase_amt.shape[0]):
                 if state.phase_amt[idx] < 1e-10:
                     state.phase_amt[idx] = 0
-            if converged:
-                converged = True
-                break
-            phase_change_counter = 5
-            state.free_stable_compset_indices = np.array(new_free_stable_compset_indices, dtype=np.int32)
-
-        for idx in range(len(state.compsets)):
-            if idx in state.free_stable_compset_indices:
-                metastable_phase_iterations[idx] = 0
-                stable_phase_iterations[idx] += 1
-            else:
-                metastable_phase_iterations[idx] += 1
-                stable_phase_iterations[idx] = 0
-        if phase_change_counter > 0:
-            phase_change_counter -= 1
+            if not converged:
+                phase_change_counter = 5
+                state.set_free_stable_compset_indices(np.array(next_free_stable_compset_indices, dtype=np.int32))
+
+        with nogil:
+            was_free_stable[:] = is_free_stable
+            is_free_stable[:] = 0
+            for i in range(state.free_stable_compset_indices.shape[0]):
+                is_free_stable[state.free_stable_compset_indices[i]] = 1
+            phase_set_changed = False
+            for idx in range(state.num_compsets):
+                if was_free_stable[idx] != is_free_stable[idx]:
+                    phase_set_changed = True
+            if trace_length > 0:
+                _record_iteration(trace, iteration, state, phase_set_changed)
+        if converged:
+            break
+        with nogil:
+            for idx in range(state.num_compsets):
+                if is_free_stable[idx]:
+                    metastable_phase_iterations[idx] = 0
+                    stable_phase_iterations[idx] += 1
+                else:
+                    metastable_phase_iterations[idx] += 1
+                    stable_phase_iterations[idx] = 0
+            if phase_change_counter > 0:
+                phase_change_counter -= 1
     #if not converged:
     #    raise ValueError('Not converged')
     # Convert moles of formula units to phase fractions
@@ -879,4 +1481,4 @@ cpdef find_solution(list compsets, int num_statevars, int num_components,
     for cs_dof in state.dof[1:]:
         x = np.r_[x, cs_dof[num_statevars:]]
     x = np.r_[x, phase_amt]
-    return converged, x, np.array(chemical_potentials)
+    return converged, x, np.array(chemical_potentials), iteration + 1, convergence_trace(trace, iteration + 1)
@@ -4,13 +4,13 @@ cimport cython
 import numpy
 cimport numpy
 
-ctypedef void (*math_function_t)(double*, const double*, void* user_data) nogil
+ctypedef void (*math_function_t)(double*, const double*, void* user_data) noexcept nogil
 
 cdef class FastFunction:
     cdef readonly object _objref
     cdef math_function_t f_ptr
     cdef void *func_data
-    cdef void call(self, double *out, double *inp) nogil
+    cdef void call(self, double *out, double *inp) noexcept nogil
 
 @cython.final
 cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordObject]:
@@ -39,20 +39,20 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
     cdef public int phase_dof
     cdef public int num_statevars
     cdef public unicode phase_name
-    cpdef void obj(self, double[::1] out, double[::1] dof) nogil
-    cpdef void formulaobj(self, double[::1] out, double[::1] dof) nogil
-    cpdef void obj_2d(self, double[::1] out, double[:, ::1] dof) nogil
-    cpdef void obj_parameters_2d(self, double[:, ::1] out, double[:, ::1] dof, double[:, ::1] parameters) nogil
-    cpdef void formulagrad(self, double[::1] out, double[::1] dof) nogil
-    cpdef void formulahess(self, double[:,::1] out, double[::1] dof) nogil
-    cpdef void internal_cons_func(self, double[::1] out, double[::1] dof) nogil
-    cpdef void internal_cons_jac(self, double[:,::1] out, double[::1] dof) nogil
-    cpdef void internal_cons_hess(self, double[:,:,::1] out, double[::1] dof) nogil
-    cpdef void mass_obj(self, double[::1] out, double[::1] dof, int comp_idx) nogil
-    cpdef void mass_obj_2d(self, double[::1] out, double[:, ::1] dof, int comp_idx) nogil
-    cpdef void formulamole_obj(self, double[::1] out, double[::1] dof, int comp_idx) nogil
-    cpdef void formulamole_grad(self, double[::1] out, double[::1] dof, int comp_idx) nogil
-    cpdef void formulamole_hess(self, double[:,::1] out, double[::1] dof, int comp_idx) nogil
+    cpdef void obj(self, double[::1] out, double[::1] dof) noexcept nogil
+    cpdef void formulaobj(self, double[::1] out, double[::1] dof) noexcept nogil
+    cpdef void obj_2d(self, double[::1] out, double[:, ::1] dof) noexcept nogil
+    cpdef void obj_parameters_2d(self, double[:, ::1] out, double[:, ::1] dof, double[:, ::1] parameters) noexcept nogil
+    cpdef void formulagrad(self, double[::1] out, double[::1] dof) noexcept nogil
+    cpdef void formulahess(self, double[:,::1] out, double[::1] dof) noexcept nogil
+    cpdef void internal_cons_func(self, double[::1] out, double[::1] dof) noexcept nogil
+    cpdef void internal_cons_jac(self, double[:,::1] out, double[::1] dof) noexcept nogil
+    cpdef void internal_cons_hess(self, double[:,:,::1] out, double[::1] dof) noexcept nogil
+    cpdef void mass_obj(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil
+    cpdef void mass_obj_2d(self, double[::1] out, double[:, ::1] dof, int comp_idx) noexcept nogil
+    cpdef void formulamole_obj(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil
+    cpdef void formulamole_grad(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil
+    cpdef void formulamole_hess(self, double[:,::1] out, double[::1] dof, int comp_idx) noexcept nogil
     # Used only to reconstitute if pickled (i.e. via __reduce__)
     cdef public object ofunc_
     cdef public object formulaofunc_
@@ -24,7 +24,7 @@ cdef class FastFunction:
         self.func_data =  (<void**><size_t>ctypes.addressof(addr2))[0]
     def __reduce__(self):
         return FastFunction, (self._objref,)
-    cdef void call(self, double *out, double *inp) nogil:
+    cdef void call(self, double *out, double *inp) noexcept nogil:
         if self.f_ptr != NULL:
             self.f_ptr(out, inp, self.func_data)
 
@@ -160,7 +160,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void obj(self, double[::1] outp, double[::1] dof) nogil:
+    cpdef void obj(self, double[::1] outp, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         cdef int num_dof = self.num_statevars + self.phase_dof + self.parameters.shape[0]
@@ -170,7 +170,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulaobj(self, double[::1] outp, double[::1] dof) nogil:
+    cpdef void formulaobj(self, double[::1] outp, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         cdef int num_dof = self.num_statevars + self.phase_dof + self.parameters.shape[0]
@@ -180,7 +180,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void obj_2d(self, double[::1] outp, double[:, ::1] dof) nogil:
+    cpdef void obj_2d(self, double[::1] outp, double[:, ::1] dof) noexcept nogil:
         # dof.shape[1] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters_vectorized(dof[:, :self.num_statevars+self.phase_dof], self.parameters)
         cdef int i
@@ -193,7 +193,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void obj_parameters_2d(self, double[:, ::1] outp, double[:, ::1] dof, double[:, ::1] parameters) nogil:
+    cpdef void obj_parameters_2d(self, double[:, ::1] outp, double[:, ::1] dof, double[:, ::1] parameters) noexcept nogil:
         """
         Calculate objective function using custom parameters.
         Note dof and parameters are vectorized separately, i.e., broadcast against each other.
@@ -222,7 +222,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulagrad(self, double[::1] out, double[::1] dof) nogil:
+    cpdef void formulagrad(self, double[::1] out, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         self._formulagrad.call(&out[0], &dof_concat[0])
@@ -232,7 +232,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulahess(self, double[:, ::1] out, double[::1] dof) nogil:
+    cpdef void formulahess(self, double[:, ::1] out, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         self._formulahess.call(&out[0,0], &dof_concat[0])
@@ -242,7 +242,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void internal_cons_func(self, double[::1] out, double[::1] dof) nogil:
+    cpdef void internal_cons_func(self, double[::1] out, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         self._internal_cons_func.call(&out[0], &dof_concat[0])
@@ -251,7 +251,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void internal_cons_jac(self, double[:, ::1] out, double[::1] dof) nogil:
+    cpdef void internal_cons_jac(self, double[:, ::1] out, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         self._internal_cons_jac.call(&out[0, 0], &dof_concat[0])
@@ -260,7 +260,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void internal_cons_hess(self, double[:, :, ::1] out, double[::1] dof) nogil:
+    cpdef void internal_cons_hess(self, double[:, :, ::1] out, double[::1] dof) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         self._internal_cons_hess.call(&out[0, 0, 0], &dof_concat[0])
@@ -269,7 +269,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void mass_obj(self, double[::1] out, double[::1] dof, int comp_idx) nogil:
+    cpdef void mass_obj(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         (<FastFunction>self._masses_ptr[comp_idx]).call(&out[0], &dof_concat[0])
@@ -278,7 +278,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void mass_obj_2d(self, double[::1] out, double[:, ::1] dof, int comp_idx) nogil:
+    cpdef void mass_obj_2d(self, double[::1] out, double[:, ::1] dof, int comp_idx) noexcept nogil:
         # dof.shape[1] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters_vectorized(dof[:, :self.num_statevars+self.phase_dof], self.parameters)
         cdef int i
@@ -289,9 +289,42 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
         if self.parameters.shape[0] > 0:
             free(dof_concat)
 
+    def obj_mass_2d_nogil(self, object outp, double[::1, :] mass_outp, double[:, ::1] dof,
+                          double[:, ::1] parameters):
+        """
+        Evaluate the objective function and the mass of every component at each row of dof,
+        releasing the GIL so that blocks of rows can be evaluated from concurrent threads.
+
+        Parameters
+        ----------
+        outp : ndarray
+            Output of the objective function. Shape (M,) if parameters has no rows, otherwise (M, N).
+        mass_outp : ndarray
+            Fortran-ordered output of shape (M, num_components).
+        dof : ndarray
+            Inputs of shape (M, num_statevars + phase_dof).
+        parameters : ndarray
+            Vectorized parameter values of shape (N, num_parameters). May have zero rows.
+        """
+        cdef double[::1] outp_1d
+        cdef double[:, ::1] outp_2d
+        cdef int comp_idx
+        cdef bint vectorized_parameters = parameters.shape[0] > 0
+        if vectorized_parameters:
+            outp_2d = outp
+        else:
+            outp_1d = outp
+        with nogil:
+            if vectorized_parameters:
+                self.obj_parameters_2d(outp_2d, dof, parameters)
+            else:
+                self.obj_2d(outp_1d, dof)
+            for comp_idx in range(mass_outp.shape[1]):
+                self.mass_obj_2d(mass_outp[:, comp_idx], dof, comp_idx)
+
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulamole_obj(self, double[::1] out, double[::1] dof, int comp_idx) nogil:
+    cpdef void formulamole_obj(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         (<FastFunction>self._formulamoles_ptr[comp_idx]).call(&out[0], &dof_concat[0])
@@ -300,7 +333,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulamole_grad(self, double[::1] out, double[::1] dof, int comp_idx) nogil:
+    cpdef void formulamole_grad(self, double[::1] out, double[::1] dof, int comp_idx) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         (<FastFunction>self._formulamolegrads_ptr[comp_idx]).call(&out[0], &dof_concat[0])
@@ -309,7 +342,7 @@ cdef public class PhaseRecord(object)[type PhaseRecordType, object PhaseRecordOb
 
     @cython.boundscheck(False)
     @cython.wraparound(False)
-    cpdef void formulamole_hess(self, double[:,::1] out, double[::1] dof, int comp_idx) nogil:
+    cpdef void formulamole_hess(self, double[:,::1] out, double[::1] dof, int comp_idx) noexcept nogil:
         # dof.shape[0] may be oversized by the caller; do not trust it
         cdef double* dof_concat = alloc_dof_with_parameters(dof[:self.num_statevars+self.phase_dof], self.parameters)
         (<FastFunction>self._formulamolehessians_ptr[comp_idx]).call(&out[0,0], &dof_concat[0])
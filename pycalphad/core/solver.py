@@ -3,12 +3,21 @@ from collections import namedtuple
 from pycalphad.core.constants import MIN_SITE_FRACTION
 from pycalphad.core.minimizer import find_solution
 
-SolverResult = namedtuple('SolverResult', ['converged', 'x', 'chemical_potentials'])
+# iterations and trace (see pycalphad.core.minimizer.CONVERGENCE_TRACE_DTYPE) are None for solvers that do not record them
+SolverResult = namedtuple('SolverResult', ['converged', 'x', 'chemical_potentials', 'iterations', 'trace'],
+                          defaults=(None, None))
+# Initial guess for a solver, typically taken from a previous solution of a nearby problem.
+# phase_amounts are phase fractions in the same order as the composition sets of the problem.
+# Without stable_compset_indices, composition sets with a positive phase amount are taken as stable;
+# if there are none, phase_amounts is ignored.
+# A trusted warm start lets the solver skip the heuristics it uses to approach an unknown solution.
+WarmStart = namedtuple('WarmStart', ['chemical_potentials', 'phase_amounts', 'stable_compset_indices', 'trusted'],
+                       defaults=(None, None, None, False))
 
 class SolverBase(object):
     """"Base class for solvers."""
     ignore_convergence = False
-    def solve(self, prob):
+    def solve(self, prob, warm_start=None):
         """
         *Implement this method.*
         Solve a non-linear problem
@@ -16,6 +25,8 @@ class SolverBase(object):
         Parameters
         ----------
         prob : pycalphad.core.problem.Problem
+        warm_start : pycalphad.core.solver.WarmStart, optional
+            Initial guess for the solution. Solvers may ignore it.
 
         Returns
         -------
@@ -25,16 +36,43 @@ class SolverBase(object):
 
 
 class SundmanSolver(SolverBase):
-    def __init__(self, verbose=False, **options):
+    """
+    Solver based on the method of Sundman et al. (2015).
+
+    Parameters
+    ----------
+    verbose : bool, optional
+        Print the chemical potentials and solution of each problem.
+    use_qr : bool, optional
+        Solve the equilibrium system with a QR factorization when it is well-conditioned,
+        falling back to the SVD otherwise. The SVD is always used by default.
+    dense_assembly : bool, optional
+        Build the component rows of the equilibrium matrix entry by entry for each phase,
+        instead of from per-phase block projections.
+    line_search : bool, optional
+        Try the full Newton step for the site fractions every iteration, and backtrack until the
+        mass balance residual decreases sufficiently. By default, a heuristic step size is used.
+    trace_length : int, optional
+        Number of most recent iterations recorded in the trace of each SolverResult.
+    """
+    def __init__(self, verbose=False, use_qr=False, dense_assembly=False, line_search=False, trace_length=64,
+                 **options):
         self.verbose = verbose
+        self.use_qr = use_qr
+        self.dense_assembly = dense_assembly
+        self.line_search = line_search
+        self.trace_length = trace_length
 
-    def solve(self, prob):
+    def solve(self, prob, warm_start=None):
         """
         Solve a non-linear problem
 
         Parameters
         ----------
         prob : pycalphad.core.problem.Problem
+        warm_start : WarmStart, optional
+            Chemical potentials, phase fractions and free stable composition sets to start from.
+            Fields which are None keep their default initial values.
 
         Returns
         -------
@@ -69,13 +107,22 @@ class SundmanSolver(SolverBase):
                 fixed_statevar_indices.append(statevar_idx)
         free_statevar_indices = np.array(sorted(set(range(num_statevars)) - set(fixed_statevar_indices)), dtype=np.int32)
         fixed_statevar_indices = np.array(fixed_statevar_indices, dtype=np.int32)
-        converged, x, chemical_potentials = \
+        if warm_start is None:
+            warm_start = WarmStart()
+        converged, x, chemical_potentials, iterations, trace = \
             find_solution(compsets, num_statevars, num_components, prescribed_system_amount,
                           chemical_potentials, free_chemical_potential_indices, fixed_chemical_potential_indices,
                           prescribed_element_indices, prescribed_elemental_amounts,
-                          free_statevar_indices, fixed_statevar_indices)
+                          free_statevar_indices, fixed_statevar_indices, use_qr=self.use_qr,
+                          dense_assembly=self.dense_assembly, line_search=self.line_search,
+                          trace_length=self.trace_length,
+                          warm_start_chemical_potentials=warm_start.chemical_potentials,
+                          warm_start_phase_amounts=warm_start.phase_amounts,
+                          warm_start_stable_compset_indices=warm_start.stable_compset_indices,
+                          trust_warm_start=warm_start.trusted)
 
         if self.verbose:
             print('Chemical Potentials', chemical_potentials)
             print(np.asarray(x))
-        return SolverResult(converged=converged, x=x, chemical_potentials=chemical_potentials)
+        return SolverResult(converged=converged, x=x, chemical_potentials=chemical_potentials,
+                            iterations=iterations, trace=trace)
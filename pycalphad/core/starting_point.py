@@ -1,6 +1,6 @@
 from pycalphad import variables as v
 from pycalphad.core.lower_convex_hull import lower_convex_hull
-from pycalphad.core.light_dataset import LightDataset
+from pycalphad.core.light_dataset import LightDataset, create_memmap_dataset
 from xarray import Dataset
 import numpy as np
 from collections import OrderedDict
@@ -35,7 +35,8 @@ def global_min_is_possible(conditions, state_variables):
     return global_min
 
 
-def starting_point(conditions, state_variables, phase_records, grid):
+def starting_point(conditions, state_variables, phase_records, grid, out_dir=None, executor=None,
+                   hull_index=None, diagnostics=False):
     """
     Find a starting point for the solution using a sample of the system energy surface.
 
@@ -50,6 +51,16 @@ def starting_point(conditions, state_variables, phase_records, grid):
     grid : Dataset
         A sample of the energy surface of the system. The sample should at least
         cover the same state variable space as specified in the conditions.
+    out_dir : str, optional
+        If specified, the result arrays are memory-mapped .npy files in this existing
+        directory instead of in-memory arrays. See `create_memmap_dataset`.
+    executor : concurrent.futures.Executor, optional
+        Thread-based executor used to find the lower convex hull at blocks of conditions concurrently.
+    hull_index : bool or LowerHullIndex, optional
+        Answer composition conditions from precomputed lower hull facets of grid.
+        See `lower_convex_hull`.
+    diagnostics : bool, optional
+        Add per-condition hyperplane() statistics to the result. See `lower_convex_hull`.
 
     Returns
     -------
@@ -78,27 +89,33 @@ def starting_point(conditions, state_variables, phase_records, grid):
     if len(dependent_comp) != 1:
         raise ValueError('Number of dependent components different from one')
 
-    ds_vars = {'NP':     (conds_as_strings + ['vertex'], np.empty(grid_shape + (len(nonvacant_elements)+1,))),
-               'GM':     (conds_as_strings, np.empty(grid_shape)),
-               'MU':     (conds_as_strings + ['component'], np.empty(grid_shape + (len(nonvacant_elements),))),
+    num_vertices = len(nonvacant_elements) + 1
+    ds_vars = {'NP':     (conds_as_strings + ['vertex'], grid_shape + (num_vertices,), np.float_),
+               'GM':     (conds_as_strings, grid_shape, np.float_),
+               'MU':     (conds_as_strings + ['component'], grid_shape + (len(nonvacant_elements),), np.float_),
                'X':      (conds_as_strings + ['vertex', 'component'],
-                          np.empty(grid_shape + (len(nonvacant_elements)+1, len(nonvacant_elements),))),
+                          grid_shape + (num_vertices, len(nonvacant_elements),), np.float_),
                'Y':      (conds_as_strings + ['vertex', 'internal_dof'],
-                          np.empty(grid_shape + (len(nonvacant_elements)+1, maximum_internal_dof,))),
-               'Phase':  (conds_as_strings + ['vertex'],
-                          np.empty(grid_shape + (len(nonvacant_elements)+1,), dtype='U%s' % max_phase_name_len)),
-               'points': (conds_as_strings + ['vertex'],
-                          np.empty(grid_shape + (len(nonvacant_elements)+1,), dtype=np.int32))
+                          grid_shape + (num_vertices, maximum_internal_dof,), np.float_),
+               'Phase':  (conds_as_strings + ['vertex'], grid_shape + (num_vertices,), 'U%s' % max_phase_name_len),
                }
 
     # If we have free state variables, they will also be data variables / output variables
     free_statevars = sorted(set(state_variables) - set(conditions.keys()))
     for f_sv in free_statevars:
-        ds_vars.update({str(f_sv): (conds_as_strings, np.empty(grid_shape))})
+        ds_vars.update({str(f_sv): (conds_as_strings, grid_shape, np.float_)})
 
-    result = LightDataset(ds_vars, coords=coord_dict, attrs={'engine': 'pycalphad %s' % pycalphad_version})
+    attrs = {'engine': 'pycalphad %s' % pycalphad_version}
+    if out_dir is None:
+        result = LightDataset({var: (dims, np.empty(shape, dtype=dtype)) for var, (dims, shape, dtype) in ds_vars.items()},
+                              coords=coord_dict, attrs=attrs)
+    else:
+        result = create_memmap_dataset(out_dir, ds_vars, coords=coord_dict, attrs=attrs)
+    # Scratch space for lower_convex_hull, which removes it from the result
+    result.add_variable('points', conds_as_strings + ['vertex'], np.empty(grid_shape + (num_vertices,), dtype=np.int32))
     if global_min_enabled:
-        result = lower_convex_hull(grid, state_variables, result)
+        result = lower_convex_hull(grid, state_variables, result, executor=executor, hull_index=hull_index,
+                                   diagnostics=diagnostics)
     else:
         raise NotImplementedError('Conditions not yet supported')
 
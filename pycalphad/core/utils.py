@@ -206,6 +206,42 @@ def endmember_matrix(dof, vacancy_indices=None):
         cur_idx = end_idx
     return res_matrix
 
+def unpack_site_fractions(packed, offsets, dofs, maximum_internal_dof):
+    """
+    Expand packed site fractions into a NaN-padded array.
+
+    Parameters
+    ----------
+    packed : ndarray
+        Site fractions of all points, concatenated into a 1-D buffer.
+    offsets : ndarray of int
+        Index into 'packed' of the first site fraction of each point.
+    dofs : ndarray of int
+        Number of site fractions of each point. Same shape as 'offsets'.
+    maximum_internal_dof : int
+        Length of the last axis of the result.
+
+    Returns
+    -------
+    ndarray of shape offsets.shape + (maximum_internal_dof,)
+
+    Examples
+    --------
+    >>> unpack_site_fractions(np.array([0.2, 0.8, 1.0]), np.array([0, 2]), np.array([2, 1]), 2)
+    array([[0.2, 0.8],
+           [1. , nan]])
+    """
+    offsets = np.asarray(offsets)
+    dofs = np.asarray(dofs)
+    result = np.full(offsets.shape + (maximum_internal_dof,), np.nan)
+    # Points are grouped by their number of site fractions, of which there are only a few distinct values
+    for dof in np.unique(dofs):
+        if dof == 0:
+            continue
+        selected = dofs == dof
+        result[selected, :dof] = packed[offsets[selected][:, np.newaxis] + np.arange(dof)]
+    return result
+
 def unpack_kwarg(kwarg_obj, default_arg=None):
     """
     Keyword arguments in pycalphad can be passed as a constant value, a
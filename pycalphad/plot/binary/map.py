@@ -7,6 +7,7 @@ from pycalphad.codegen.callables import build_phase_records
 from pycalphad.core.eqsolver import _solve_eq_at_conditions
 from pycalphad.core.equilibrium import _adjust_conditions
 from pycalphad.core.starting_point import starting_point
+from pycalphad.core.lower_convex_hull import prune_grid, LowerHullIndex
 from pycalphad.core.utils import instantiate_models, get_state_variables, \
     unpack_components, unpack_condition, filter_phases, get_pure_elements
 from .compsets import get_compsets, find_two_phase_region_compsets
@@ -110,7 +111,11 @@ def map_binary(dbf, comps, phases, conds, eq_kwargs=None, calc_kwargs=None,
         grid = calculate(dbf, comps, phases, fake_points=True, output='GM',
                          T=T, P=grid_conds[v.P], N=1, model=models,
                          parameters=parameters, to_xarray=False, **calc_kwargs)
-        hull = starting_point(eq_conds, statevars, prxs, grid)
+        grid = prune_grid(grid)
+        # Every starting point at this temperature is located on the same hull facets
+        hull_index = LowerHullIndex(grid)
+        hull = starting_point(eq_conds, statevars, prxs, grid, executor=calc_kwargs.get('executor'),
+                              hull_index=hull_index)
         convex_hull_time += time.time() - hull_time
         convex_hulls_calculated += 1
         while Xmax_visited < Xmax:
@@ -122,7 +127,7 @@ def map_binary(dbf, comps, phases, conds, eq_kwargs=None, calc_kwargs=None,
             Xeq = hull_compsets.mean_composition
             eq_conds[comp_cond] = [float(Xeq)]
             eq_time = time.time()
-            start_point = starting_point(eq_conds, statevars, prxs, grid)
+            start_point = starting_point(eq_conds, statevars, prxs, grid, hull_index=hull_index)
             eq_ds = _solve_eq_at_conditions(species, start_point, prxs, grid, str_conds, statevars, False)
             equilibrium_time += time.time() - eq_time
             equilibria_calculated += 1
@@ -147,7 +152,7 @@ def map_binary(dbf, comps, phases, conds, eq_kwargs=None, calc_kwargs=None,
                 eq_conds[comp_cond] = [float(Xmax_visited + dX)]
                 eq_time = time.time()
                 # TODO: starting point could be improved by basing it off the previous calculation
-                start_point = starting_point(eq_conds, statevars, prxs, grid)
+                start_point = starting_point(eq_conds, statevars, prxs, grid, hull_index=hull_index)
                 eq_ds = _solve_eq_at_conditions(species, start_point, prxs, grid, str_conds, statevars, False)
                 equilibrium_time += time.time() - eq_time
                 equilibria_calculated += 1
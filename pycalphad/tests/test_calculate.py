@@ -3,17 +3,21 @@ The calculate test module verifies that calculate() calculates
 Model quantities correctly.
 """
 
+from concurrent.futures import ThreadPoolExecutor
 import pytest
 from pycalphad import Database, calculate, Model
 import numpy as np
-from numpy.testing import assert_allclose
+from numpy.testing import assert_allclose, assert_array_equal
 from pycalphad import ConditionError
-from pycalphad.tests.datasets import ALCRNI_TDB as TDB_TEST_STRING, ALFE_TDB, CUMG_PARAMETERS_TDB
+from pycalphad.core.calculate import calculate_chunked
+from pycalphad.core.utils import unpack_site_fractions
+from pycalphad.tests.datasets import ALCRNI_TDB as TDB_TEST_STRING, ALFE_TDB, CUMG_PARAMETERS_TDB, ALNIPT_TDB
 
 
 DBF = Database(TDB_TEST_STRING)
 ALFE_DBF = Database(ALFE_TDB)
 CUMG_PARAMETERS_DBF = Database(CUMG_PARAMETERS_TDB)
+ALNIPT_DBF = Database(ALNIPT_TDB)
 
 def test_surface():
     "Bare minimum: calculation produces a result."
@@ -106,3 +110,75 @@ def test_single_model_instance_raises():
     mod = Model(DBF, comps, 'L12_FCC')  # Model instance does not match the phase
     with pytest.raises(ValueError):
         calculate(DBF, comps, ['LIQUID', 'L12_FCC'], T=1400.0, output='_fail_', model=mod)
+
+
+def test_calculate_packed_site_fractions_match_padded():
+    "Packed site fractions from a LightDataset unpack to the padded Y of the xarray result."
+    comps = ['AL', 'CR', 'NI']
+    phases = ['L12_FCC', 'LIQUID']
+    packed = calculate(DBF, comps, phases, T=[300, 1400], pdens=10, fake_points=True, to_xarray=False)
+    padded = calculate(DBF, comps, phases, T=[300, 1400], pdens=10, fake_points=True)
+    assert 'Y' not in packed.data_vars
+    assert packed.Y_offsets.shape == packed.GM.shape
+    assert np.all(packed.Y_dof[..., :len(comps)] == 0)
+    unpacked = unpack_site_fractions(packed.Y_packed, packed.Y_offsets, packed.Y_dof, padded.Y.shape[-1])
+    assert_array_equal(unpacked, padded.Y.values)
+
+
+def test_calculate_chunked_matches_calculate():
+    "Chunks from calculate_chunked reassemble to the result of calculate."
+    comps = ['AL', 'CR', 'NI']
+    temps = [300, 800, 1400]
+    full = calculate(DBF, comps, ['L12_FCC', 'LIQUID'], T=temps, P=101325, pdens=10, to_xarray=False)
+    chunks = list(calculate_chunked(DBF, comps, ['L12_FCC', 'LIQUID'], T=temps, P=101325, pdens=10,
+                                    memory_budget=10000))
+    assert len(chunks) > 2
+    phase_offset = 0
+    for phase_name in ['L12_FCC', 'LIQUID']:
+        phase_chunks = [(index, chunk) for name, index, chunk in chunks if name == phase_name]
+        num_points = max(index[-1].stop for index, _ in phase_chunks)
+        energies = np.full(full.GM.shape[:-1] + (num_points,), np.nan)
+        for index, chunk in phase_chunks:
+            assert np.all(chunk.phase_names[chunk.Phase_id] == phase_name)
+            energies[index] = chunk.GM
+        assert_allclose(energies, full.GM[..., phase_offset:phase_offset+num_points])
+        phase_offset += num_points
+    assert phase_offset == full.GM.shape[-1]
+
+
+def test_calculate_with_executor_matches_serial():
+    "Evaluating grid points with a thread pool gives the same result as serial evaluation."
+    comps = ['AL', 'CR', 'NI']
+    phases = ['L12_FCC', 'LIQUID']
+    serial = calculate(DBF, comps, phases, T=[300, 1400], pdens=50, fake_points=True, to_xarray=False)
+    with ThreadPoolExecutor(max_workers=2) as executor:
+        threaded = calculate(DBF, comps, phases, T=[300, 1400], pdens=50, fake_points=True, to_xarray=False,
+                             executor=executor)
+    assert_array_equal(threaded.GM, serial.GM)
+    assert_array_equal(threaded.X, serial.X)
+    assert_array_equal(threaded.Phase_id, serial.Phase_id)
+
+
+def test_calculate_phase_codes_match_phase_names():
+    "Integer phase codes of a LightDataset grid map to the phase names of the xarray result."
+    comps = ['AL', 'CR', 'NI']
+    phases = ['L12_FCC', 'LIQUID']
+    coded = calculate(DBF, comps, phases, T=300, pdens=10, fake_points=True, to_xarray=False)
+    named = calculate(DBF, comps, phases, T=300, pdens=10, fake_points=True)
+    assert coded.Phase_id.dtype == np.int16
+    assert list(coded.phase_names) == ['_FAKE_', 'L12_FCC', 'LIQUID']
+    assert_array_equal(coded.phase_names[coded.Phase_id], named.Phase.values)
+    assert 'phase_names' not in named.coords
+
+
+def test_calculate_symmetry_reduction_samples_one_representative():
+    "Symmetry reduction of an ordered phase samples fewer points with the energies of their symmetric copies."
+    comps = ['AL', 'NI', 'VA']
+    full = calculate(ALNIPT_DBF, comps, 'FCC_L12', T=1000, pdens=20)
+    reduced = calculate(ALNIPT_DBF, comps, 'FCC_L12', T=1000, pdens=20, symmetry_reduction=True)
+    assert reduced.GM.shape[-1] < full.GM.shape[-1] / 5
+    points = reduced.Y.values.squeeze()
+    # Swap the first and last substitutional sublattices (two site fractions each)
+    permuted = np.concatenate((points[:, 6:8], points[:, 2:6], points[:, 0:2], points[:, 8:]), axis=1)
+    permuted_result = calculate(ALNIPT_DBF, comps, 'FCC_L12', T=1000, points=permuted)
+    assert_allclose(permuted_result.GM.values.squeeze(), reduced.GM.values.squeeze(), atol=1e-6)
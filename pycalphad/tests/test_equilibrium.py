@@ -5,14 +5,22 @@ correct solution for thermodynamic equilibrium.
 
 import warnings
 import os
+from concurrent.futures import ThreadPoolExecutor
 import pytest
 from sympy import Symbol
 from numpy.testing import assert_allclose
+from scipy.optimize import linprog
 import numpy as np
 from pycalphad import Database, Model, calculate, equilibrium, EquilibriumError, ConditionError
 from pycalphad.codegen.callables import build_callables
-from pycalphad.core.solver import SolverBase, SundmanSolver
-from pycalphad.core.utils import get_state_variables
+from pycalphad.core.solver import SolverBase, SundmanSolver, WarmStart
+from pycalphad.core.problem import Problem
+from pycalphad.core.composition_set import CompositionSet
+from pycalphad.core.light_dataset import LightDataset, open_memmap_dataset
+from pycalphad.core.lower_convex_hull import prune_grid, lower_convex_hull, LowerHullIndex
+from pycalphad.core.cartesian import cartesian
+from pycalphad.core.hyperplane import hyperplane, hull_conditions, HyperplaneWorkspace
+from pycalphad.core.utils import get_state_variables, unpack_components, unpack_site_fractions
 import pycalphad.variables as v
 from pycalphad.tests.datasets import *
 
@@ -590,3 +598,398 @@ def test_eq_issue259():
     eq = equilibrium(dbf, comps, ['B2_BCC'], {v.P: 101325, v.N: 1, v.T: 1013, v.MU('AL'): -95906})
     assert_allclose(eq.GM.values, -65786.260)
     assert_allclose(eq.MU.values.flatten(), [-95906., -52877.592122])
+
+
+def test_prune_grid_keeps_fictitious_and_lowest_points():
+    "Grid pruning removes high-energy points but keeps the fictitious points and the low-energy surface."
+    comps = ['AL', 'FE', 'VA']
+    phases = ['LIQUID', 'FCC_A1', 'AL13FE4', 'AL5FE2', 'AL2FE']
+    grid = calculate(ALFE_DBF, comps, phases, T=[300, 1400], P=101325, N=1,
+                     fake_points=True, pdens=50, to_xarray=False)
+    # Unpacked site fractions are pruned like any other variable with a 'points' dimension
+    maximum_internal_dof = int(grid.Y_dof.max())
+    grid.add_variable('Y', grid.data_vars['Y_offsets'][0] + ['internal_dof'],
+                      unpack_site_fractions(grid.Y_packed, grid.Y_offsets, grid.Y_dof, maximum_internal_dof))
+    pruned = prune_grid(grid, margin=1000)
+    assert pruned.GM.shape[-1] < grid.GM.shape[-1]
+    assert pruned.GM.shape[:-1] == grid.GM.shape[:-1]
+    assert pruned.X.shape[-1] == grid.X.shape[-1]
+    assert np.all(pruned.Phase_id[..., :2] == 0)
+    assert_allclose(np.nanmin(pruned.GM, axis=-1), np.nanmin(grid.GM, axis=-1))
+    # Site fractions of removed points are dropped from the packed buffer
+    assert pruned.Y_packed.shape[0] < grid.Y_packed.shape[0]
+    np.testing.assert_array_equal(unpack_site_fractions(pruned.Y_packed, pruned.Y_offsets, pruned.Y_dof,
+                                                        maximum_internal_dof), pruned.Y)
+
+
+def test_eq_out_dir_matches_in_memory_result(tmp_path):
+    "Equilibrium results written to memory-mapped files match the in-memory result and can be reopened."
+    comps = ['AL', 'FE', 'VA']
+    phases = ['LIQUID', 'FCC_A1', 'B2_BCC']
+    conds = {v.T: [1000, 1400], v.P: 101325, v.N: 1, v.X('AL'): [0.2, 0.4]}
+    in_memory = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False)
+    on_disk = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False, out_dir=str(tmp_path))
+    reopened = open_memmap_dataset(str(tmp_path))
+    for var in ['GM', 'MU', 'NP', 'X', 'Y', 'Phase']:
+        np.testing.assert_array_equal(getattr(on_disk, var), getattr(in_memory, var))
+        np.testing.assert_array_equal(getattr(reopened, var), getattr(in_memory, var))
+    assert 'points' not in reopened.data_vars
+
+
+def _synthetic_binary_grid(num_points=400, temperature=500):
+    """
+    Compositions and energies of a regular solution sampled at num_points compositions, after
+    two high-energy fictitious pure points. Below about 1200 K it has a miscibility gap.
+    """
+    x = np.linspace(1e-6, 1 - 1e-6, num_points)
+    compositions = np.ascontiguousarray(np.vstack((np.eye(2), np.column_stack((x, 1 - x)))))
+    energies = np.concatenate(([1e10, 1e10], 8.314 * temperature * (x * np.log(x) + (1 - x) * np.log(1 - x)) +
+                               20000 * x * (1 - x)))
+    return compositions, energies
+
+
+def test_hyperplane_workspace_reuse_matches_fresh_buffers():
+    "hyperplane() gives the same result with a reused, growing workspace as with temporary buffers."
+    workspace = HyperplaneWorkspace(1, 1)
+    for num_points in [10, 500, 50]:
+        compositions, energies = _synthetic_binary_grid(num_points, temperature=1000)
+        results = []
+        for ws in [None, workspace]:
+            chempots = np.zeros(2)
+            fractions = np.zeros(3)
+            simplex = np.zeros(3, dtype=np.int32)
+            energy = hyperplane(compositions, energies, np.array([0.3, 0.7]), chempots, 1.0,
+                                np.array([], dtype=np.uintp), np.array([0], dtype=np.uintp),
+                                fractions, simplex, ws)
+            results.append((energy, chempots, fractions, simplex))
+        assert results[0][0] == results[1][0]
+        for fresh, reused in zip(results[0][1:], results[1][1:]):
+            np.testing.assert_array_equal(fresh, reused)
+
+
+def test_eq_with_executor_matches_serial():
+    "Solving the convex hull of blocks of conditions on a thread pool gives the serial result."
+    comps = ['AL', 'FE', 'VA']
+    phases = ['LIQUID', 'FCC_A1', 'B2_BCC']
+    conds = {v.T: [1000, 1400], v.P: 101325, v.N: 1, v.X('AL'): np.linspace(0.05, 0.6, 40)}
+    serial = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False)
+    with ThreadPoolExecutor(max_workers=2) as executor:
+        threaded = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False, executor=executor)
+    for var in ['GM', 'MU', 'NP', 'X', 'Y', 'Phase']:
+        np.testing.assert_array_equal(getattr(threaded, var), getattr(serial, var))
+
+
+@pytest.mark.solver
+def test_eq_concurrent_solves_match_serial():
+    "Equilibrium calls on separate threads, whose Newton iterations release the GIL, give the serial results."
+    comps = ['AL', 'FE', 'VA']
+    phases = ['LIQUID', 'FCC_A1', 'B2_BCC']
+    temperatures = [800, 1000, 1200, 1400]
+
+    def solve(temperature):
+        conds = {v.T: temperature, v.P: 101325, v.N: 1, v.X('AL'): np.linspace(0.05, 0.6, 12)}
+        return equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False)
+
+    serial = [solve(temperature) for temperature in temperatures]
+    with ThreadPoolExecutor(max_workers=4) as executor:
+        threaded = list(executor.map(solve, temperatures))
+    for serial_result, threaded_result in zip(serial, threaded):
+        for var in ['GM', 'MU', 'NP', 'Phase']:
+            np.testing.assert_array_equal(getattr(threaded_result, var), getattr(serial_result, var))
+
+
+@pytest.mark.solver
+@pytest.mark.parametrize('solver_options', [{'use_qr': True}, {'dense_assembly': True}, {'line_search': True}])
+def test_eq_solver_options_match_default(solver_options):
+    "Optional QR solve, dense assembly and line search give the same equilibria as the default solver."
+    comps = ['AL', 'FE', 'VA']
+    phases = ['LIQUID', 'FCC_A1', 'B2_BCC']
+    conds = {v.T: [800, 1200], v.P: 101325, v.N: 1, v.X('AL'): np.linspace(0.05, 0.6, 12)}
+    default_result = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False)
+    option_result = equilibrium(ALFE_DBF, comps, phases, conds, to_xarray=False,
+                                solver=SundmanSolver(**solver_options))
+    np.testing.assert_array_equal(option_result.Phase, default_result.Phase)
+    assert_allclose(option_result.GM, default_result.GM, rtol=1e-8)
+    assert_allclose(option_result.MU, default_result.MU, rtol=1e-6)
+
+
+@pytest.mark.solver
+def test_eq_diagnostics_count_solver_iterations():
+    "With diagnostics, equilibrium adds the total solver iterations and hull statistics of each condition."
+    conds = {v.T: [800, 1200], v.P: 101325, v.N: 1, v.X('AL'): [0.1, 0.3, 0.5]}
+    eq = equilibrium(ALFE_DBF, ['AL', 'FE', 'VA'], ['LIQUID', 'FCC_A1', 'B2_BCC'], conds,
+                     to_xarray=False, diagnostics=True)
+    assert eq.solver_iterations.shape == eq.GM.shape
+    assert np.all(eq.solver_iterations > 0)
+    assert eq.hull_iterations.shape == eq.GM.shape
+
+
+@pytest.mark.solver
+def test_solver_result_convergence_trace():
+    "SundmanSolver results carry the iteration count and a ring buffer trace of the last iterations."
+    class RecordingSolver(SundmanSolver):
+        def solve(self, prob):
+            self.results.append(super(RecordingSolver, self).solve(prob))
+            return self.results[-1]
+    solver = RecordingSolver(trace_length=4)
+    solver.results = []
+    equilibrium(ALFE_DBF, ['AL', 'FE', 'VA'], ['LIQUID', 'FCC_A1', 'B2_BCC'],
+                {v.T: 1200, v.P: 101325, v.N: 1, v.X('AL'): 0.3}, solver=solver)
+    result = solver.results[-1]
+    assert result.converged
+    assert len(result.trace) == min(result.iterations, 4)
+    np.testing.assert_array_equal(result.trace['iteration'],
+                                  np.arange(result.iterations - len(result.trace), result.iterations))
+    assert result.trace['mass_residual'][-1] < 1e-8
+    assert np.all(result.trace['num_stable_phases'] > 0)
+
+
+def _alfe_warm_start_problem():
+    """
+    Solve AL-FE at 1200 K and X(AL)=0.3, and return a function building fresh copies of its composition sets,
+    the converged result, and the components and conditions of a nearby problem at X(AL)=0.32.
+    """
+    class RecordingSolver(SundmanSolver):
+        def solve(self, prob, **kwargs):
+            self.last = (prob, super(RecordingSolver, self).solve(prob, **kwargs))
+            return self.last[1]
+    solver = RecordingSolver()
+    equilibrium(ALFE_DBF, ['AL', 'FE', 'VA'], ['LIQUID', 'FCC_A1', 'B2_BCC'],
+                {v.T: 1200, v.P: 101325, v.N: 1, v.X('AL'): 0.3}, solver=solver)
+    prob, previous = solver.last
+    assert previous.converged
+    comps = sorted(unpack_components(ALFE_DBF, ['AL', 'FE', 'VA']))
+    conds = dict(prob.conditions)
+    conds['X_AL'] += 0.02
+
+    def copy_composition_sets():
+        compsets = []
+        for compset in prob.composition_sets:
+            num_statevars = len(compset.phase_record.state_variables)
+            new_compset = CompositionSet(compset.phase_record)
+            new_compset.update(np.array(compset.dof[num_statevars:]), compset.NP, np.array(compset.dof[:num_statevars]))
+            compsets.append(new_compset)
+        return compsets
+    return copy_composition_sets, previous, comps, conds
+
+
+@pytest.mark.solver
+def test_solver_trusted_warm_start_skips_warm_up():
+    "A trusted warm start from a nearby solution converges to the same result in fewer iterations."
+    copy_composition_sets, previous, comps, conds = _alfe_warm_start_problem()
+    num_compsets = len(copy_composition_sets())
+    results = []
+    for warm_start in (None, WarmStart(previous.chemical_potentials,
+                                       [compset.NP for compset in copy_composition_sets()],
+                                       list(range(num_compsets)), trusted=True)):
+        results.append(SundmanSolver().solve(Problem(copy_composition_sets(), comps, conds), warm_start=warm_start))
+    cold, warm = results
+    assert cold.converged and warm.converged
+    assert warm.iterations < cold.iterations
+    assert_allclose(warm.chemical_potentials, cold.chemical_potentials, atol=1e-6)
+
+
+@pytest.mark.solver
+def test_solver_warm_start_from_phase_amounts_only():
+    """
+    Without stable composition sets, a warm start takes the composition sets seeded with a positive amount
+    as stable, and falls back to the default stable set when none is seeded.
+    """
+    copy_composition_sets, previous, comps, conds = _alfe_warm_start_problem()
+    cold = SundmanSolver().solve(Problem(copy_composition_sets(), comps, conds))
+    assert cold.converged
+    seeded_amounts = [compset.NP for compset in copy_composition_sets()]
+    for phase_amounts in (seeded_amounts, [0.0] * len(seeded_amounts)):
+        warm = SundmanSolver().solve(Problem(copy_composition_sets(), comps, conds),
+                                     warm_start=WarmStart(phase_amounts=phase_amounts))
+        assert warm.converged
+        assert_allclose(warm.chemical_potentials, cold.chemical_potentials, atol=1e-6)
+
+
+def test_hull_conditions_removes_fictitious_vertices():
+    "The compiled hull driver copies out grid values and clears fictitious vertices from the simplex."
+    x = np.linspace(0.3, 0.7, 41)
+    grid_X = np.ascontiguousarray(np.vstack((np.eye(2), np.column_stack((x, 1 - x))))[np.newaxis])
+    grid_GM = np.concatenate(([1e4, 1e4], -1000 - 4000 * x * (1 - x)))[np.newaxis]
+    grid_phase_ids = np.array([[0, 0] + [1] * len(x)], dtype=np.int16)
+    grid_Y_dof = np.array([[2, 2] + [2] * len(x)], dtype=np.int32)
+    grid_Y_offsets = np.arange(grid_X.shape[1], dtype=np.int64)[np.newaxis] * 2
+    grid_Y_packed = grid_X.reshape(-1)
+    comp_values = np.array([[0.1, 0.0], [0.5, 0.0]])
+    num_conds, num_vertices = 2, 3
+    result_GM = np.empty(num_conds)
+    result_MU = np.empty((num_conds, 2))
+    result_NP = np.empty((num_conds, num_vertices))
+    result_points = np.empty((num_conds, num_vertices), dtype=np.int32)
+    result_X = np.empty((num_conds, num_vertices, 2))
+    result_Y = np.empty((num_conds, num_vertices, 2))
+    result_phase_ids = np.empty((num_conds, num_vertices), dtype=np.int16)
+    hull_conditions(grid_X, grid_GM, grid_phase_ids, grid_Y_offsets, grid_Y_dof, grid_Y_packed,
+                    np.zeros(num_conds, dtype=np.intp), comp_values, np.arange(num_conds, dtype=np.intp),
+                    np.empty((1, 0)), np.zeros(num_conds, dtype=np.intp),
+                    np.array([], dtype=np.uintp), np.array([0], dtype=np.uintp), 1.0,
+                    result_GM, result_MU, result_NP, result_points, result_X, result_Y, result_phase_ids,
+                    np.full(num_conds, -1, dtype=np.intp), 0, num_conds)
+    # X(A)=0.1 is outside the real points, so one vertex of the simplex is fictitious
+    assert sorted(result_phase_ids[0, :2]) == [-1, 1]
+    fake_vertex = list(result_phase_ids[0, :2]).index(-1)
+    assert np.isnan(result_NP[0, fake_vertex])
+    assert np.all(np.isnan(result_X[0, fake_vertex]))
+    assert np.all(np.isnan(result_Y[0, fake_vertex]))
+    assert np.isfinite(result_GM[0])
+    # X(A)=0.5 is on the real surface
+    assert np.all(result_phase_ids[1, :2] == 1)
+    assert_allclose(result_GM[1], -2000, atol=1e-8)
+    np.testing.assert_array_equal(result_Y[1, :2], result_X[1, :2])
+    assert np.all(result_phase_ids[:, 2] == -1)
+
+
+def test_hyperplane_warm_start_matches_cold_start():
+    "Starting hyperplane() from the simplex of the previous composition gives the same hull."
+    # Miscibility gap, so some simplices span two points far apart
+    compositions, energies = _synthetic_binary_grid()
+    previous_simplex = None
+    for target in np.linspace(0.01, 0.99, 50):
+        results = []
+        for initial_simplex in [None, previous_simplex]:
+            chempots = np.zeros(2)
+            fractions = np.zeros(3)
+            simplex = np.zeros(3, dtype=np.int32)
+            energy = hyperplane(compositions, energies, np.array([target, 1 - target]), chempots, 1.0,
+                                np.array([], dtype=np.uintp), np.array([0], dtype=np.uintp),
+                                fractions, simplex, None, initial_simplex)
+            results.append((energy, chempots))
+        assert_allclose(results[1][0], results[0][0], rtol=1e-10)
+        assert_allclose(results[1][1], results[0][1], rtol=1e-8)
+        previous_simplex = simplex[:2].copy()
+
+
+def test_hyperplane_workspace_reuse_across_component_counts():
+    """
+    A workspace grown for a binary system finds the lower convex hull of a ternary system, with and without
+    a fixed chemical potential. The chemical potentials must give a hyperplane on or below every point, touching
+    the points of the simplex; without fixed potentials, the energy and simplex must match a linear program.
+    """
+    workspace = HyperplaneWorkspace(100, 2)
+    # (number of components, lattice steps, target composition, fixed chemical potentials)
+    cases = [(2, 300, [0.371, 0.629], {}), (3, 40, [0.31, 0.27, 0.42], {}),
+             (3, 40, [0.31, 0.27, 0.42], {2: 8.314 * 1000 * np.log(0.2)})]
+    for num_components, num_steps, target, fixed_chempots in cases:
+        lattice = np.indices((num_steps + 1,) * (num_components - 1)).reshape(num_components - 1, -1).T
+        lattice = lattice[lattice.sum(axis=1) <= num_steps]
+        x = np.column_stack((lattice, num_steps - lattice.sum(axis=1))) / num_steps
+        x = np.clip(x, 1e-12, 1)
+        x /= x.sum(axis=1)[:, np.newaxis]
+        compositions = np.ascontiguousarray(np.vstack((np.eye(num_components), x)))
+        energies = np.concatenate((np.full(num_components, 1e10), 8.314 * 1000 * np.sum(x * np.log(x), axis=1)))
+        target = np.array(target)
+        fixed_chempot_indices = np.array(sorted(fixed_chempots), dtype=np.uintp)
+        fixed_comp_indices = np.arange(num_components - 1 - len(fixed_chempots), dtype=np.uintp)
+        simplex_size = num_components - len(fixed_chempots)
+        for ws in [None, workspace]:
+            chempots = np.zeros(num_components)
+            for idx, mu in fixed_chempots.items():
+                chempots[idx] = mu
+            fractions = np.zeros(num_components + 1)
+            simplex = np.zeros(num_components + 1, dtype=np.int32)
+            energy = hyperplane(compositions, energies, target, chempots, 1.0,
+                                fixed_chempot_indices, fixed_comp_indices, fractions, simplex, ws)
+            for idx, mu in fixed_chempots.items():
+                assert chempots[idx] == mu
+            driving_forces = energies - np.dot(compositions, chempots)
+            assert np.all(driving_forces > -1e-6)
+            assert_allclose(driving_forces[simplex[:simplex_size]], 0, atol=1e-6)
+            if len(fixed_chempots) == 0:
+                # Minimize the energy of 1 mole of a mixture of points at the target composition
+                reference = linprog(energies, A_eq=np.vstack((compositions[:, fixed_comp_indices].T, np.ones(len(energies)))),
+                                    b_eq=np.append(target[fixed_comp_indices], 1.0), bounds=(0, None), method='highs')
+                assert reference.success
+                assert_allclose(energy, reference.fun, rtol=1e-10)
+                np.testing.assert_array_equal(np.sort(simplex[:simplex_size]), np.nonzero(reference.x > 1e-9)[0])
+
+
+def test_lower_hull_index_matches_hyperplane():
+    "Locating compositions on precomputed hull facets gives the same hull as hyperplane()."
+    compositions, energies = _synthetic_binary_grid()
+    phase_ids = np.array([0, 0] + [1] * (len(compositions) - 2), dtype=np.int16)
+    grid = LightDataset({'X': (['points', 'component'], compositions), 'GM': (['points'], energies),
+                         'Phase_id': (['points'], phase_ids)}, coords={})
+    hull_index = LowerHullIndex(grid)
+    targets = np.column_stack((np.linspace(0.01, 0.99, 30), 1 - np.linspace(0.01, 0.99, 30)))
+    facets = hull_index.locate(0, targets)
+    # Fictitious points are never part of the index
+    assert np.all(hull_index.simplices[0] >= 2)
+    for target, facet in zip(targets, facets):
+        chempots = np.zeros(2)
+        energy = hyperplane(compositions, energies, target, chempots, 1.0, np.array([], dtype=np.uintp),
+                            np.array([0], dtype=np.uintp), np.zeros(3), np.zeros(3, dtype=np.int32))
+        assert_allclose(np.dot(target, hull_index.potentials[0][facet]), energy, rtol=1e-10)
+        assert_allclose(hull_index.potentials[0][facet], chempots, rtol=1e-6)
+
+
+def test_lower_convex_hull_fully_open_matches_hyperplane():
+    "The fully open fast path of lower_convex_hull() selects the same point as hyperplane() for every condition."
+    rng = np.random.RandomState(1769)
+    for components in [['A', 'B'], ['A', 'B', 'C']]:
+        num_components = len(components)
+        # The last component is free. Include points where it is nearly absent, as well as the fictitious points.
+        nearly_pure = rng.dirichlet(np.ones(num_components - 1), 20) * (1 - 1e-10)
+        x = np.vstack((rng.dirichlet(np.ones(num_components), 500),
+                       np.column_stack((nearly_pure, np.full(len(nearly_pure), 1e-10)))))
+        compositions = np.ascontiguousarray(np.vstack((np.eye(num_components), x)))
+        energies = np.concatenate((np.full(num_components, 1e10),
+                                   8.314 * 500 * np.sum(x * np.log(x), axis=1) + 20000 * x[:, 0] * x[:, 1]))
+        num_points = len(energies)
+        grid = LightDataset({'X': (['points', 'component'], compositions), 'GM': (['points'], energies),
+                             'Phase_id': (['points'], np.array([0] * num_components + [1] * len(x), dtype=np.int16)),
+                             'Y_offsets': (['points'], np.zeros(num_points, dtype=np.int64)),
+                             'Y_dof': (['points'], np.zeros(num_points, dtype=np.int32)),
+                             'Y_packed': (['packed_dof'], np.zeros(0))},
+                            coords={'component': components, 'phase_names': np.array(['_FAKE_', 'SOLUTION']),
+                                    'N': [1.0]})
+        pot_conds = ['MU_' + comp for comp in components[:-1]]
+        pot_values = np.linspace(-30000, 2000, 12)
+        conds_shape = (len(pot_values),) * len(pot_conds)
+        num_vertices = num_components + 1
+        coords = {cond: pot_values for cond in pot_conds}
+        coords.update({'component': components, 'vertex': np.arange(num_vertices)})
+        result = LightDataset({'GM': (pot_conds, np.empty(conds_shape)),
+                               'MU': (pot_conds + ['component'], np.empty(conds_shape + (num_components,))),
+                               'NP': (pot_conds + ['vertex'], np.empty(conds_shape + (num_vertices,))),
+                               'X': (pot_conds + ['vertex', 'component'],
+                                     np.empty(conds_shape + (num_vertices, num_components))),
+                               'Y': (pot_conds + ['vertex', 'internal_dof'], np.empty(conds_shape + (num_vertices, 1))),
+                               'Phase': (pot_conds + ['vertex'], np.empty(conds_shape + (num_vertices,), dtype='U8')),
+                               'points': (pot_conds + ['vertex'], np.empty(conds_shape + (num_vertices,), dtype=np.int32))},
+                              coords=coords)
+        lower_convex_hull(grid, [], result)
+        result_GM = result.GM.reshape(-1)
+        result_MU = result.MU.reshape(-1, num_components)
+        result_X = result.X.reshape(-1, num_vertices, num_components)
+        for cond_idx, fixed_potentials in enumerate(cartesian([pot_values] * len(pot_conds))):
+            chempots = np.zeros(num_components)
+            chempots[:-1] = fixed_potentials
+            simplex = np.zeros(num_vertices, dtype=np.int32)
+            energy = hyperplane(compositions, energies, np.zeros(num_components), chempots, 1.0,
+                                np.arange(num_components - 1, dtype=np.uintp), np.array([], dtype=np.uintp),
+                                np.zeros(num_vertices), simplex)
+            assert_allclose(result_GM[cond_idx], energy, rtol=1e-10)
+            assert_allclose(result_MU[cond_idx], chempots, rtol=1e-8)
+            np.testing.assert_array_equal(result_X[cond_idx, 0], compositions[simplex[0]])
+
+
+def test_hyperplane_statistics():
+    "hyperplane() reports its iterations and pruning without changing its result."
+    compositions, energies = _synthetic_binary_grid()
+    results = []
+    statistics = np.full(4, -1, dtype=np.int32)
+    for stats in [None, statistics]:
+        chempots = np.zeros(2)
+        energy = hyperplane(compositions, energies, np.array([0.3, 0.7]), chempots, 1.0, np.array([], dtype=np.uintp),
+                            np.array([0], dtype=np.uintp), np.zeros(3), np.zeros(3, dtype=np.int32), None, None, stats)
+        results.append(energy)
+    assert results[0] == results[1]
+    iterations, singular_solves, points_after_first_pass, points_remaining = statistics
+    assert iterations > 1
+    assert singular_solves == 0
+    assert len(compositions) >= points_after_first_pass >= points_remaining > 0